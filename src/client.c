@@ -57,8 +57,10 @@
 #include "screen.h"
 #include "session.h"
 #include "settings.h"
+#include "spatial.h"
 #include "stacking.h"
 #include "startup_notification.h"
+#include "tiling.h"
 #include "transients.h"
 #include "workspaces.h"
 #include "xsync.h"
@@ -585,6 +587,113 @@ clientAdjustCoordGravity (Client * c, int gravity, unsigned long *mask, XWindowC
 #define WIN_MOVED   (mask & (CWX | CWY))
 #define WIN_RESIZED (mask & (CWWidth | CWHeight))
 
+#ifdef HAVE_XSYNC
+/* Ask the client to tell us when it has redrawn at its new size */
+static void
+clientConfigureSyncRequest (Client * c)
+{
+    ScreenInfo *screen_info;
+
+    screen_info = c->screen_info;
+    if (!(screen_info->display_info->have_xsync) || !(c->xsync_enabled) || !(c->xsync_counter)
+        || !FLAG_TEST (c->xfwm_flags, XFWM_FLAG_VISIBLE))
+    {
+        return;
+    }
+
+    if (!c->xsync_waiting)
+    {
+        clientXSyncRequest (c);
+    }
+    if (!c->xsync_transaction)
+    {
+        c->xsync_transaction = TRUE;
+        screen_info->configure_pending++;
+    }
+}
+#endif /* HAVE_XSYNC */
+
+static unsigned long
+clientFilterConfigure (ClientGeometryCache *cache, XWindowChanges *values, unsigned long mask)
+{
+    if (!cache->valid)
+    {
+        return mask;
+    }
+    if ((mask & CWX) && (values->x == cache->x))
+    {
+        mask &= ~CWX;
+    }
+    if ((mask & CWY) && (values->y == cache->y))
+    {
+        mask &= ~CWY;
+    }
+    if ((mask & CWWidth) && (values->width == cache->width))
+    {
+        mask &= ~CWWidth;
+    }
+    if ((mask & CWHeight) && (values->height == cache->height))
+    {
+        mask &= ~CWHeight;
+    }
+
+    return mask;
+}
+
+static void
+clientStoreConfigure (ClientGeometryCache *cache, XWindowChanges *values, unsigned long mask)
+{
+    if (mask & CWX)
+    {
+        cache->x = values->x;
+    }
+    if (mask & CWY)
+    {
+        cache->y = values->y;
+    }
+    if (mask & CWWidth)
+    {
+        cache->width = values->width;
+    }
+    if (mask & CWHeight)
+    {
+        cache->height = values->height;
+    }
+    /* Only trust the cache once every field has been sent at least once */
+    if ((mask & (CWX | CWY | CWWidth | CWHeight)) == (CWX | CWY | CWWidth | CWHeight))
+    {
+        cache->valid = TRUE;
+    }
+}
+
+static unsigned long
+clientSendConfigure (Client * c, Window w, ClientGeometryCache *cache,
+                     XWindowChanges *values, unsigned long mask, gboolean force)
+{
+    ScreenInfo *screen_info;
+    unsigned long send_mask;
+
+    screen_info = c->screen_info;
+    send_mask = mask;
+    if (!force)
+    {
+        send_mask = clientFilterConfigure (cache, values, mask);
+    }
+    if (send_mask != mask)
+    {
+        screen_info->configures_suppressed++;
+        DBG ("Skipping redundant configure on (0x%lx), %u suppressed so far",
+             w, screen_info->configures_suppressed);
+    }
+    if (send_mask)
+    {
+        XConfigureWindow (clientGetXDisplay (c), w, send_mask, values);
+        clientStoreConfigure (cache, values, send_mask);
+    }
+
+    return send_mask;
+}
+
 static void
 clientConfigureWindows (Client * c, XWindowChanges * wc, unsigned long mask, unsigned short flags)
 {
@@ -592,12 +701,23 @@ clientConfigureWindows (Client * c, XWindowChanges * wc, unsigned long mask, uns
     XWindowChanges change_values;
     DisplayInfo *display_info;
     ScreenInfo *screen_info;
+    gboolean force;
 
     screen_info = c->screen_info;
     display_info = screen_info->display_info;
 
     change_mask_frame = mask & (CWX | CWY | CWWidth | CWHeight);
     change_mask_client = mask & (CWWidth | CWHeight);
+    force = (flags & CFG_FORCE_REDRAW);
+
+#ifdef HAVE_XSYNC
+    if ((WIN_RESIZED) && (screen_info->configure_depth > 0))
+    {
+        clientConfigureSyncRequest (c);
+    }
+    /* The client answers the sync request once it gets the real configure */
+    force |= c->xsync_waiting;
+#endif /* HAVE_XSYNC */
 
     if ((WIN_RESIZED) || (flags & CFG_FORCE_REDRAW))
     {
@@ -615,7 +735,8 @@ clientConfigureWindows (Client * c, XWindowChanges * wc, unsigned long mask, uns
         change_values.y = frameY (c);
         change_values.width = frameWidth (c);
         change_values.height = frameHeight (c);
-        XConfigureWindow (display_info->dpy, c->frame, change_mask_frame, &change_values);
+        clientSendConfigure (c, c->frame, &c->frame_sent, &change_values,
+                             change_mask_frame, force);
     }
 
     if (change_mask_client & (CWX | CWY | CWWidth | CWHeight))
@@ -624,7 +745,12 @@ clientConfigureWindows (Client * c, XWindowChanges * wc, unsigned long mask, uns
         change_values.y = frameTop (c);
         change_values.width = c->width;
         change_values.height = c->height;
-        XConfigureWindow (display_info->dpy, c->window, change_mask_client, &change_values);
+        if (clientSendConfigure (c, c->window, &c->window_sent, &change_values,
+                                 change_mask_client, force))
+        {
+            /* The client now holds the real, frame relative event */
+            c->notify_sent.valid = FALSE;
+        }
     }
     if (WIN_RESIZED)
     {
@@ -636,6 +762,7 @@ void
 clientConfigure (Client * c, XWindowChanges * wc, unsigned long mask, unsigned short flags)
 {
     XConfigureEvent ce;
+    ScreenInfo *screen_info;
     int px, py, pwidth, pheight;
 
     g_return_if_fail (c != NULL);
@@ -645,6 +772,7 @@ clientConfigure (Client * c, XWindowChanges * wc, unsigned long mask, unsigned s
     TRACE ("configuring client \"%s\" (0x%lx) %s, type %u", c->name,
         c->window, flags & CFG_CONSTRAINED ? "constrained" : "not contrained", c->type);
 
+    screen_info = c->screen_info;
     px = c->x;
     py = c->y;
     pwidth = c->width;
@@ -763,6 +891,7 @@ clientConfigure (Client * c, XWindowChanges * wc, unsigned long mask, unsigned s
     }
 
     clientConfigureWindows (c, wc, mask, flags);
+    spatialUpdateClient (c);
     /*
 
       We reparent the client window. According to the ICCCM spec, the
@@ -781,6 +910,20 @@ clientConfigure (Client * c, XWindowChanges * wc, unsigned long mask, unsigned s
     if ((WIN_MOVED) || (flags & CFG_NOTIFY) ||
         ((flags & CFG_REQUEST) && !(WIN_MOVED || WIN_RESIZED)))
     {
+        /*
+           A ConfigureRequest always gets its reply, as the ICCCM mandates,
+           otherwise the client may already know this geometry.
+         */
+        if (c->notify_sent.valid && !(flags & (CFG_REQUEST | CFG_FORCE_REDRAW)) &&
+            (c->notify_sent.x == c->x) && (c->notify_sent.y == c->y) &&
+            (c->notify_sent.width == c->width) && (c->notify_sent.height == c->height))
+        {
+            screen_info->notifies_suppressed++;
+            DBG ("Skipping duplicate ConfigureNotify, %u suppressed so far",
+                 screen_info->notifies_suppressed);
+            return;
+        }
+
         DBG ("Sending ConfigureNotify");
         ce.type = ConfigureNotify;
         ce.display = clientGetXDisplay (c);
@@ -795,11 +938,114 @@ clientConfigure (Client * c, XWindowChanges * wc, unsigned long mask, unsigned s
         ce.override_redirect = FALSE;
         XSendEvent (clientGetXDisplay (c), c->window, FALSE,
                     StructureNotifyMask, (XEvent *) & ce);
+
+        c->notify_sent.x = c->x;
+        c->notify_sent.y = c->y;
+        c->notify_sent.width = c->width;
+        c->notify_sent.height = c->height;
+        c->notify_sent.valid = TRUE;
     }
 #undef WIN_MOVED
 #undef WIN_RESIZED
 }
 
+static void
+clientConfigureRelease (ScreenInfo *screen_info)
+{
+    if ((screen_info->configure_depth > 0) || (screen_info->configure_pending > 0))
+    {
+        return;
+    }
+    if (screen_info->configure_timeout_id)
+    {
+        g_source_remove (screen_info->configure_timeout_id);
+        screen_info->configure_timeout_id = 0;
+    }
+    compositorHoldRepaint (screen_info, FALSE);
+}
+
+static gboolean
+clientConfigureTimeout (gpointer data)
+{
+    ScreenInfo *screen_info;
+#ifdef HAVE_XSYNC
+    Client *c;
+    guint i;
+#endif /* HAVE_XSYNC */
+
+    TRACE ("entering clientConfigureTimeout");
+
+    screen_info = (ScreenInfo *) data;
+    screen_info->configure_timeout_id = 0;
+
+    /* Too late, do not wait for the slow ones anymore */
+#ifdef HAVE_XSYNC
+    for (c = screen_info->clients, i = 0; i < screen_info->client_count; c = c->next, i++)
+    {
+        c->xsync_transaction = FALSE;
+    }
+#endif /* HAVE_XSYNC */
+    screen_info->configure_pending = 0;
+    clientConfigureRelease (screen_info);
+
+    return (FALSE);
+}
+
+/*
+   Transactions group the configuration of several windows: the
+   compositor does not repaint until every resized client supporting
+   _NET_WM_SYNC_REQUEST has redrawn or CLIENT_CONFIGURE_TIMEOUT expires,
+   so the changes reach the screen as a single frame. Transactions nest.
+ */
+void
+clientConfigureBegin (ScreenInfo *screen_info)
+{
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering clientConfigureBegin");
+
+    if (screen_info->configure_depth++ == 0)
+    {
+        compositorHoldRepaint (screen_info, TRUE);
+    }
+}
+
+void
+clientConfigureEnd (ScreenInfo *screen_info)
+{
+    g_return_if_fail (screen_info != NULL);
+    g_return_if_fail (screen_info->configure_depth > 0);
+    TRACE ("entering clientConfigureEnd");
+
+    if (--screen_info->configure_depth > 0)
+    {
+        return;
+    }
+
+    XFlush (myScreenGetXDisplay (screen_info));
+    if ((screen_info->configure_pending > 0) && (screen_info->configure_timeout_id == 0))
+    {
+        screen_info->configure_timeout_id =
+            g_timeout_add (CLIENT_CONFIGURE_TIMEOUT, clientConfigureTimeout, screen_info);
+    }
+    clientConfigureRelease (screen_info);
+}
+
+void
+clientConfigureAck (Client * c)
+{
+    g_return_if_fail (c != NULL);
+    TRACE ("entering clientConfigureAck");
+
+#ifdef HAVE_XSYNC
+    if (c->xsync_transaction)
+    {
+        c->xsync_transaction = FALSE;
+        c->screen_info->configure_pending--;
+        clientConfigureRelease (c->screen_info);
+    }
+#endif /* HAVE_XSYNC */
+}
+
 void
 clientMoveResizeWindow (Client * c, XWindowChanges * wc, unsigned long mask)
 {
@@ -1241,10 +1487,7 @@ clientFree (Client * c)
     {
         g_source_remove (c->icon_timeout_id);
     }
-    if (c->frame_timeout_id)
-    {
-        g_source_remove (c->frame_timeout_id);
-    }
+    frameClearQueueDraw (c);
     if (c->ping_timeout_id)
     {
         clientRemoveNetWMPing (c);
@@ -1561,6 +1804,34 @@ clientUpdateIcon (Client * c)
     }
 }
 
+static void
+clientSetWindowIndex (Client *c, gboolean add)
+{
+    DisplayInfo *display_info;
+    void (*func) (DisplayInfo *, Window, Client *, unsigned short);
+    int i;
+
+    display_info = c->screen_info->display_info;
+    func = add ? myDisplayAddClientWindow : myDisplayRemoveClientWindow;
+
+    func (display_info, c->window, c, SEARCH_WINDOW);
+    func (display_info, c->frame, c, SEARCH_FRAME);
+    func (display_info, MYWINDOW_XWINDOW (c->title), c, SEARCH_DECORATION);
+    func (display_info, MYWINDOW_XWINDOW (c->decoration), c, SEARCH_DECORATION);
+    for (i = 0; i < SIDE_COUNT; i++)
+    {
+        func (display_info, MYWINDOW_XWINDOW (c->sides[i]), c, SEARCH_DECORATION);
+    }
+    for (i = 0; i < CORNER_COUNT; i++)
+    {
+        func (display_info, MYWINDOW_XWINDOW (c->corners[i]), c, SEARCH_DECORATION);
+    }
+    for (i = 0; i < BUTTON_COUNT; i++)
+    {
+        func (display_info, MYWINDOW_XWINDOW (c->buttons[i]), c, SEARCH_BUTTON);
+    }
+}
+
 Client *
 clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
 {
@@ -1673,6 +1944,7 @@ clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
 #ifdef HAVE_XSYNC
     c->xsync_waiting = FALSE;
     c->xsync_enabled = FALSE;
+    c->xsync_transaction = FALSE;
     c->xsync_counter = None;
     c->xsync_alarm = None;
     c->xsync_timeout_id = 0;
@@ -1734,6 +2006,10 @@ clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
     c->opacity_applied = c->opacity;
     c->opacity_flags = 0;
 
+    /* Not tiled until placed in a layout */
+    c->tile_layout = NULL;
+    c->tile_node = NULL;
+
     /* Keep count of blinking iterations */
     c->blink_iterations = 0;
 
@@ -1744,8 +2020,6 @@ clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
 
     /* Timout for asynchronous icon update */
     c->icon_timeout_id = 0;
-    /* Timout for asynchronous frame update */
-    c->frame_timeout_id = 0;
     /* Timeout for blinking on urgency */
     c->blink_timeout_id = 0;
     /* Ping timeout  */
@@ -1929,36 +2203,51 @@ clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
         xfwmPixmapInit (screen_info, &c->appmenu[i]);
     }
 
-    for (i = 0; i < SIDE_TOP; i++) /* Keep SIDE_TOP for later */
+    c->pointer_part = FRAME_PART_NONE;
+    xfwmPixmapInit (screen_info, &c->decoration_pm);
+    if (screen_info->params->single_window_frame)
     {
+        /* One window for the whole decoration, parts are found by hit testing */
+        FLAG_SET (c->xfwm_flags, XFWM_FLAG_SINGLE_FRAME);
         xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
-            &c->sides[i], NoEventMask,
-            myDisplayGetCursorResize(screen_info->display_info, CORNER_COUNT + i));
+            &c->decoration, NoEventMask, None);
+        /* It spans the whole frame, keep it below the client window */
+        XLowerWindow (display_info->dpy, MYWINDOW_XWINDOW (c->decoration));
     }
-
-    for (i = 0; i < CORNER_COUNT; i++)
+    else
     {
-        xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
-            &c->corners[i], NoEventMask,
-            myDisplayGetCursorResize(screen_info->display_info, i));
-    }
+        for (i = 0; i < SIDE_TOP; i++) /* Keep SIDE_TOP for later */
+        {
+            xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
+                &c->sides[i], NoEventMask,
+                myDisplayGetCursorResize(screen_info->display_info, CORNER_COUNT + i));
+        }
 
-    xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
-        &c->title, NoEventMask, None);
+        for (i = 0; i < CORNER_COUNT; i++)
+        {
+            xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
+                &c->corners[i], NoEventMask,
+                myDisplayGetCursorResize(screen_info->display_info, i));
+        }
 
-    /* create the top side window AFTER the title window since they overlap
-       and the top side window should be on top */
+        xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
+            &c->title, NoEventMask, None);
 
-    xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
-        &c->sides[SIDE_TOP], NoEventMask,
-        myDisplayGetCursorResize(screen_info->display_info,
-        CORNER_COUNT + SIDE_TOP));
+        /* create the top side window AFTER the title window since they overlap
+           and the top side window should be on top */
+
+        xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
+            &c->sides[SIDE_TOP], NoEventMask,
+            myDisplayGetCursorResize(screen_info->display_info,
+            CORNER_COUNT + SIDE_TOP));
+    }
 
     for (i = 0; i < BUTTON_COUNT; i++)
     {
         xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
             &c->buttons[i], BUTTON_EVENT_MASK, None);
     }
+    clientSetWindowIndex (c, TRUE);
     clientUpdateIconPix (c);
 
     /* Put the window on top to avoid XShape, that speeds up hw accelerated
@@ -2022,6 +2311,8 @@ clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
     myDisplayUngrabServer (display_info);
     gdk_error_trap_pop ();
 
+    tilingManageClient (c);
+
     DBG ("client \"%s\" (0x%lx) is now managed", c->name, c->window);
     DBG ("client_count=%d", screen_info->client_count);
 
@@ -2047,6 +2338,10 @@ clientUnframe (Client * c, gboolean remap)
     display_info = screen_info->display_info;
 
     clientRemoveFromList (c);
+    clientSetWindowIndex (c, FALSE);
+    spatialRemoveClient (c);
+    clientConfigureAck (c);
+    tilingUnmanageClient (c);
     compositorSetClient (display_info, c->frame, NULL);
 
     myDisplayGrabServer (display_info);
@@ -2093,6 +2388,8 @@ clientUnframe (Client * c, gboolean remap)
     }
 
     xfwmWindowDelete (&c->title);
+    xfwmWindowDelete (&c->decoration);
+    xfwmPixmapFree (&c->decoration_pm);
 
     for (i = 0; i < SIDE_COUNT; i++)
     {
@@ -2279,6 +2576,7 @@ clientSetWorkspaceSingle (Client * c, guint ws)
     if (c->win_workspace != ws)
     {
         TRACE ("setting client \"%s\" (0x%lx) to current_ws %d", c->name, c->window, ws);
+        tilingUpdateWorkspace (c, ws);
         c->win_workspace = ws;
         setHint (display_info, c->window, WIN_WORKSPACE, ws);
         if (FLAG_TEST (c->flags, CLIENT_FLAG_STICKY))
@@ -2365,6 +2663,11 @@ clientShowSingle (Client * c, gboolean deiconify)
         {
             XMapWindow (display_info->dpy, c->window);
         }
+        /* Redraws requested while hidden were left for now */
+        if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_REDRAW_DEFERRED))
+        {
+            frameQueueDraw (c, FALSE);
+        }
         /* Adjust to urgency state as the window is visible */
         clientUpdateUrgency (c);
     }
@@ -2372,6 +2675,8 @@ clientShowSingle (Client * c, gboolean deiconify)
     {
         FLAG_UNSET (c->flags, CLIENT_FLAG_ICONIFIED);
         setWMState (display_info, c->window, NormalState);
+        /* Give the window its tile back */
+        tilingRefreshClient (c);
     }
     clientSetNetActions (c);
     clientSetNetState (c);
@@ -2435,6 +2740,8 @@ clientWithdrawSingle (Client * c, GList *exclude_list, gboolean iconify)
         {
             clientSetLast (c);
         }
+        /* Let the other tiles use the room left */
+        tilingRefreshClient (c);
     }
     clientSetNetActions (c);
     clientSetNetState (c);
@@ -2915,6 +3222,9 @@ clientStick (Client * c, gboolean include_transients)
     screen_info = c->screen_info;
     display_info = screen_info->display_info;
 
+    /* Sticky windows float above all workspaces */
+    tilingUnmanageClient (c);
+
     if (include_transients)
     {
         list_of_windows = clientListTransientOrModal (c);
@@ -3356,6 +3666,11 @@ clientToggleMaximized (Client * c, int mode, gboolean restore_position)
     if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_MANAGED) && (restore_position))
     {
         clientConfigure (c, &wc, CWWidth | CWHeight | CWX | CWY, CFG_FORCE_REDRAW);
+        if (!FLAG_TEST (c->flags, CLIENT_FLAG_MAXIMIZED))
+        {
+            /* Back from maximization, put the window back in its tile */
+            tilingRefreshClient (c);
+        }
     }
     clientSetNetState (c);
 }
@@ -3559,7 +3874,7 @@ clientScreenResize(ScreenInfo *screen_info, gboolean fully_visible)
             wc.height = c->height;
             clientConfigure (c, &wc, CWX | CWY | CWWidth | CWHeight, CFG_NOTIFY);
         }
-        else
+        else if (!c->tile_layout)
         {
             configure_flags = CFG_CONSTRAINED | CFG_REQUEST;
             if (fully_visible)
@@ -3574,6 +3889,9 @@ clientScreenResize(ScreenInfo *screen_info, gboolean fully_visible)
     }
 
     g_list_free (list_of_windows);
+
+    /* Tiled windows follow their layout */
+    tilingScreenResize (screen_info);
 }
 
 static eventFilterStatus
@@ -104,6 +104,10 @@
 #define CLIENT_XSYNC_TIMEOUT            1000 /* ms */
 #endif
 
+#ifndef CLIENT_CONFIGURE_TIMEOUT
+#define CLIENT_CONFIGURE_TIMEOUT        100  /* ms */
+#endif
+
 #ifndef CLIENT_BLINK_TIMEOUT
 #define CLIENT_BLINK_TIMEOUT            500  /* ms */
 #endif
@@ -139,6 +143,9 @@
 #define XFWM_FLAG_MOVING_RESIZING       (1L<<21)
 #define XFWM_FLAG_NEEDS_REDRAW          (1L<<22)
 #define XFWM_FLAG_OPACITY_LOCKED        (1L<<23)
+#define XFWM_FLAG_SINGLE_FRAME          (1L<<24)
+#define XFWM_FLAG_REDRAW_QUEUED         (1L<<25)
+#define XFWM_FLAG_REDRAW_DEFERRED       (1L<<26)
 
 #define CLIENT_FLAG_HAS_STRUT           (1L<<0)
 #define CLIENT_FLAG_HAS_STRUT_PARTIAL   (1L<<1)
@@ -239,6 +246,32 @@ typedef enum
 }
 netWindowType;
 
+/* What the frame shape was last computed from */
+typedef struct
+{
+    gboolean valid;
+    gint width;
+    gint height;
+    gint state;
+    unsigned long flags;
+    Pixmap title_mask;
+    Pixmap top_mask;
+    Pixmap button_mask[BUTTON_COUNT];
+    gint button_x[BUTTON_COUNT];
+}
+FrameShapeKey;
+
+/* Geometry last sent to the server or to the client */
+typedef struct
+{
+    gboolean valid;
+    gint x;
+    gint y;
+    gint width;
+    gint height;
+}
+ClientGeometryCache;
+
 struct _Client
 {
     /* Reference to our screen structure */
@@ -253,6 +286,9 @@ struct _Client
     xfwmWindow sides[SIDE_COUNT];
     xfwmWindow corners[CORNER_COUNT];
     xfwmWindow buttons[BUTTON_COUNT];
+    /* Title, sides and corners painted together, in single window mode */
+    xfwmWindow decoration;
+    xfwmPixmap decoration_pm;
     Window client_leader;
     Window group_leader;
     xfwmPixmap appmenu[STATE_TOGGLED];
@@ -293,6 +329,11 @@ struct _Client
     gint ncmap;
     gint blink_iterations;
     gint button_status[BUTTON_COUNT];
+    gint pointer_part;
+    FrameShapeKey shape_key;
+    ClientGeometryCache frame_sent;
+    ClientGeometryCache window_sent;
+    ClientGeometryCache notify_sent;
     gint struts[STRUTS_SIZE];
     gchar *hostname;
     gchar *name;
@@ -309,8 +350,6 @@ struct _Client
     gint dialog_fd;
     /* Timout for asynchronous icon update */
     guint icon_timeout_id;
-    /* Timout for asynchronous frame update */
-    guint frame_timeout_id;
     /* Timout to manage blinking decorations for urgent windows */
     guint blink_timeout_id;
     /* Timout for asynchronous icon update */
@@ -319,6 +358,13 @@ struct _Client
     guint opacity;
     guint opacity_applied;
     guint opacity_flags;
+    /* Tiling layout the client belongs to, if any */
+    TileLayout *tile_layout;
+    TileNode *tile_node;
+    /* Cells of the spatial grid the frame covers (x1, y1, x2, y2) */
+    gint spatial_cells[4];
+    gboolean spatial_indexed;
+    guint spatial_mark;
 
 #ifdef HAVE_LIBSTARTUP_NOTIFICATION
     /* Startup notification */
@@ -332,6 +378,7 @@ struct _Client
     guint xsync_timeout_id;
     gboolean xsync_waiting;
     gboolean xsync_enabled;
+    gboolean xsync_transaction;
 #endif /* HAVE_XSYNC */
 };
 
@@ -356,6 +403,9 @@ void                     clientConfigure                        (Client *,
                                                                  XWindowChanges *,
                                                                  unsigned long,
                                                                  unsigned short);
+void                     clientConfigureBegin                   (ScreenInfo *);
+void                     clientConfigureEnd                     (ScreenInfo *);
+void                     clientConfigureAck                     (Client *);
 void                     clientMoveResizeWindow                 (Client *,
                                                                  XWindowChanges *,
                                                                  unsigned long);
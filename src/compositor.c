@@ -34,6 +34,7 @@
 #include <glib.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
 #include <libxfce4util/libxfce4util.h>
 
 #include "display.h"
@@ -42,6 +43,7 @@
 #include "frame.h"
 #include "hints.h"
 #include "compositor.h"
+#include "focus.h"
 
 #ifdef HAVE_COMPOSITOR
 
@@ -84,9 +86,35 @@
 #define WIN_IS_VISIBLE(cw)              (WIN_IS_VIEWABLE(cw) && WIN_HAS_DAMAGE(cw))
 #define WIN_IS_DAMAGED(cw)              (cw->damaged)
 #define WIN_IS_REDIRECTED(cw)           (cw->redirected)
+#define WIN_HAS_SHADOW(cw)              ((cw->shadow) || (cw->shadow_level >= 0))
 
-/* Set TIMEOUT_REPAINT to 0 to disable timeout repaint */
-#define TIMEOUT_REPAINT       10 /* msec.) */
+/* Values of _NET_WM_BYPASS_COMPOSITOR, the unredirect rules map to these too */
+#define BYPASS_NONE             0
+#define BYPASS_UNREDIRECT       1
+#define BYPASS_REDIRECT         2
+
+/* Unfocused windows flooding us with damage are repaired at most this often, in ms */
+#ifndef THROTTLE_INTERVAL
+#define THROTTLE_INTERVAL       100
+#endif /* THROTTLE_INTERVAL */
+
+/* Damage events per second above which a window gets throttled */
+#ifndef THROTTLE_DAMAGE_RATE
+#define THROTTLE_DAMAGE_RATE    (1000 / THROTTLE_INTERVAL)
+#endif /* THROTTLE_DAMAGE_RATE */
+
+/* Set TIMEOUT_REPAINT to 0 to disable scheduled repaints and paint after each event */
+#define TIMEOUT_REPAINT       1
+
+/* Refresh rate used when neither the settings nor XRandR give one */
+#ifndef REFRESH_RATE_FALLBACK
+#define REFRESH_RATE_FALLBACK 60 /* Hz */
+#endif /* REFRESH_RATE_FALLBACK */
+
+/* Number of frames between two dumps of the scheduler statistics */
+#ifndef FRAME_STATS_INTERVAL
+#define FRAME_STATS_INTERVAL  300
+#endif /* FRAME_STATS_INTERVAL */
 
 typedef struct _CWindow CWindow;
 struct _CWindow
@@ -94,6 +122,7 @@ struct _CWindow
     ScreenInfo *screen_info;
     Client *c;
     Window id;
+    GList *link;
     XWindowAttributes attr;
 
     gboolean damaged;
@@ -105,11 +134,26 @@ struct _CWindow
     gboolean skipped;
     gboolean native_opacity;
     gboolean opacity_locked;
+    gboolean occluded;
+    gboolean damage_held;
+    gboolean damage_queued;
+    gint bypass;
+    gboolean partly_occluded;
+    gboolean low_priority;
+
+    /* Damage accounting */
+    guint damage_events;
+    guint damage_rate;
+    guint damage_total;
+    gint64 damage_period;
+    gint64 last_repair;
 
     Damage damage;
 #if HAVE_NAME_WINDOW_PIXMAP
     Pixmap name_window_pixmap;
 #endif /* HAVE_NAME_WINDOW_PIXMAP */
+    gboolean picture_stale;
+    gboolean damaged_since_resize;
     Picture picture;
     Picture shadow;
     Picture alphaPict;
@@ -120,11 +164,14 @@ struct _CWindow
     XserverRegion clientSize;
     XserverRegion borderClip;
     XserverRegion extents;
+    /* Client side copy of the extents bounds, to avoid fetching them */
+    GdkRectangle extents_bounds;
 
     gint shadow_dx;
     gint shadow_dy;
     gint shadow_width;
     gint shadow_height;
+    gint shadow_level;
 
     guint opacity;
 };
@@ -132,21 +179,15 @@ struct _CWindow
 static CWindow*
 find_cwindow_in_screen (ScreenInfo *screen_info, Window id)
 {
-    GList *list;
-
     g_return_val_if_fail (id != None, NULL);
     g_return_val_if_fail (screen_info != NULL, NULL);
     TRACE ("entering find_cwindow_in_screen");
 
-    for (list = screen_info->cwindows; list; list = g_list_next (list))
+    if (screen_info->cwindow_hash == NULL)
     {
-        CWindow *cw = (CWindow *) list->data;
-        if (cw->id == id)
-        {
-            return cw;
-        }
+        return NULL;
     }
-    return NULL;
+    return (CWindow *) g_hash_table_lookup (screen_info->cwindow_hash, (gconstpointer) id);
 }
 
 static CWindow*
@@ -170,6 +211,77 @@ find_cwindow_in_display (DisplayInfo *display_info, Window id)
     return NULL;
 }
 
+/*
+ * screen_info->cwindows is the window stack, top first. Each CWindow
+ * keeps its own link so that it can be moved around in constant time,
+ * and cwindows_tail points to the bottom of the stack.
+ */
+static void
+stack_unlink (ScreenInfo *screen_info, CWindow *cw)
+{
+    GList *link;
+
+    link = cw->link;
+    if (link->prev)
+    {
+        link->prev->next = link->next;
+    }
+    else
+    {
+        screen_info->cwindows = link->next;
+    }
+    if (link->next)
+    {
+        link->next->prev = link->prev;
+    }
+    else
+    {
+        screen_info->cwindows_tail = link->prev;
+    }
+    link->prev = NULL;
+    link->next = NULL;
+}
+
+static void
+stack_insert_above (ScreenInfo *screen_info, CWindow *cw, CWindow *sibling)
+{
+    GList *link;
+
+    link = cw->link;
+    if (sibling == NULL)
+    {
+        /* Insert at bottom of window stack */
+        link->prev = screen_info->cwindows_tail;
+        link->next = NULL;
+        if (screen_info->cwindows_tail)
+        {
+            screen_info->cwindows_tail->next = link;
+        }
+        else
+        {
+            screen_info->cwindows = link;
+        }
+        screen_info->cwindows_tail = link;
+    }
+    else
+    {
+        GList *next;
+
+        next = sibling->link;
+        link->prev = next->prev;
+        link->next = next;
+        if (next->prev)
+        {
+            next->prev->next = link;
+        }
+        else
+        {
+            screen_info->cwindows = link;
+        }
+        next->prev = link;
+    }
+}
+
 static gboolean
 is_shaped (DisplayInfo *display_info, Window id)
 {
@@ -606,6 +718,251 @@ shadow_picture (ScreenInfo *screen_info, gdouble opacity,
     return shadowPicture;
 }
 
+static Picture
+slice_picture (ScreenInfo *screen_info, XImage *ximage, XRenderPictFormat *render_format,
+               gint x, gint y, gint width, gint height, gboolean repeat)
+{
+    DisplayInfo *display_info;
+    Pixmap pixmap;
+    Picture picture;
+    XRenderPictureAttributes pa;
+    GC gc;
+
+    display_info = screen_info->display_info;
+    pixmap = XCreatePixmap (display_info->dpy, screen_info->output, width, height, 8);
+    g_return_val_if_fail (pixmap != None, None);
+
+    pa.repeat = repeat;
+    picture = XRenderCreatePicture (display_info->dpy, pixmap,
+                                    render_format, CPRepeat, &pa);
+    if (picture == None)
+    {
+        XFreePixmap (display_info->dpy, pixmap);
+        g_warning ("(picture != None) failed");
+        return None;
+    }
+
+    gc = XCreateGC (display_info->dpy, pixmap, 0, NULL);
+    XPutImage (display_info->dpy, pixmap, gc, ximage, x, y, 0, 0, width, height);
+    XFreeGC (display_info->dpy, gc);
+    XFreePixmap (display_info->dpy, pixmap);
+
+    return picture;
+}
+
+/*
+ * Past the corners, a shadow built from the presummed tables only varies
+ * along one axis, so it can be rebuilt from a (2 * size + 1) square: the
+ * four corners, a one pixel column repeated horizontally for the top and
+ * bottom edges, a one pixel row repeated vertically for the sides, and a
+ * single pixel repeated over the centre.
+ */
+static ShadowSlices *
+get_shadow_slices (ScreenInfo *screen_info, gint level)
+{
+    DisplayInfo *display_info;
+    ShadowSlices *slices;
+    XRenderPictFormat *render_format;
+    XImage *ximage;
+    guchar *data;
+    gint gsize, size;
+    gint x, y, cx, cy;
+
+    g_return_val_if_fail (screen_info != NULL, NULL);
+    g_return_val_if_fail (level >= 0 && level < SHADOW_SLICE_LEVELS, NULL);
+    TRACE ("entering get_shadow_slices");
+
+    if (screen_info->shadowSlices[level])
+    {
+        return screen_info->shadowSlices[level];
+    }
+
+    display_info = screen_info->display_info;
+    render_format = XRenderFindStandardFormat (display_info->dpy, PictStandardA8);
+    g_return_val_if_fail (render_format != NULL, NULL);
+
+    gsize = screen_info->gaussianSize;
+    size = 2 * gsize + 1;
+    data = g_malloc (size * size * sizeof (guchar));
+    ximage = XCreateImage (display_info->dpy,
+                           DefaultVisual(display_info->dpy, screen_info->screen),
+                           8, ZPixmap, 0, (char *) data,
+                           size, size, 8, size * sizeof (guchar));
+    if (ximage == NULL)
+    {
+        g_free (data);
+        g_warning ("(ximage != NULL) failed");
+        return NULL;
+    }
+
+    /* Same values make_shadow () picks from the tables, mirrored around the centre */
+    for (y = 0; y < size; y++)
+    {
+        cy = (y <= gsize) ? y : size - y - 1;
+        for (x = 0; x < size; x++)
+        {
+            cx = (x <= gsize) ? x : size - x - 1;
+            if ((cx < gsize) && (cy < gsize))
+            {
+                data[y * size + x] = screen_info->shadowCorner[level * (gsize + 1) * (gsize + 1)
+                                                               + cy * (gsize + 1) + cx];
+            }
+            else
+            {
+                data[y * size + x] = screen_info->shadowTop[level * (gsize + 1) + MIN (cx, cy)];
+            }
+        }
+    }
+
+    slices = g_new0 (ShadowSlices, 1);
+    slices->corners = slice_picture (screen_info, ximage, render_format, 0, 0, size, size, FALSE);
+    slices->columns = slice_picture (screen_info, ximage, render_format, gsize, 0, 1, size, TRUE);
+    slices->rows = slice_picture (screen_info, ximage, render_format, 0, gsize, size, 1, TRUE);
+    slices->center = slice_picture (screen_info, ximage, render_format, gsize, gsize, 1, 1, TRUE);
+    XDestroyImage (ximage);
+
+    screen_info->shadowSlices[level] = slices;
+
+    return slices;
+}
+
+static void
+free_shadow_slices (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+    ShadowSlices *slices;
+    gint level;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering free_shadow_slices");
+
+    display_info = screen_info->display_info;
+    for (level = 0; level < SHADOW_SLICE_LEVELS; level++)
+    {
+        slices = screen_info->shadowSlices[level];
+        if (slices == NULL)
+        {
+            continue;
+        }
+        if (slices->corners)
+        {
+            XRenderFreePicture (display_info->dpy, slices->corners);
+        }
+        if (slices->columns)
+        {
+            XRenderFreePicture (display_info->dpy, slices->columns);
+        }
+        if (slices->rows)
+        {
+            XRenderFreePicture (display_info->dpy, slices->rows);
+        }
+        if (slices->center)
+        {
+            XRenderFreePicture (display_info->dpy, slices->center);
+        }
+        g_free (slices);
+        screen_info->shadowSlices[level] = NULL;
+    }
+}
+
+/*
+ * Use the shared shadow slices for the window when it is large enough for
+ * the presummed tables to apply, which is what make_shadow () would do as well.
+ */
+static gboolean
+set_shadow_slices (CWindow *cw, gdouble opacity, gint width, gint height)
+{
+    ScreenInfo *screen_info;
+    DisplayInfo *display_info;
+    gint gsize, swidth, sheight;
+    gint level;
+
+    screen_info = cw->screen_info;
+    display_info = screen_info->display_info;
+    gsize = screen_info->gaussianSize;
+    swidth = width + gsize - screen_info->params->shadow_delta_width - screen_info->params->shadow_delta_x;
+    sheight = height + gsize - screen_info->params->shadow_delta_height - screen_info->params->shadow_delta_y;
+    level = CLAMP ((gint) (opacity * 25), 0, SHADOW_SLICE_LEVELS - 1);
+
+    if ((gsize <= 0) || (swidth < 2 * gsize) || (sheight < 2 * gsize) ||
+        (get_shadow_slices (screen_info, level) == NULL))
+    {
+        cw->shadow_level = -1;
+        return FALSE;
+    }
+
+    if (cw->shadow)
+    {
+        XRenderFreePicture (display_info->dpy, cw->shadow);
+        cw->shadow = None;
+    }
+    cw->shadow_level = level;
+    cw->shadow_width = swidth;
+    cw->shadow_height = sheight;
+
+    return TRUE;
+}
+
+static void
+paint_shadow_slices (CWindow *cw, Picture dest)
+{
+    ScreenInfo *screen_info;
+    DisplayInfo *display_info;
+    ShadowSlices *slices;
+    Picture black;
+    gint x, y, w, h;
+    gint gsize, mid_w, mid_h;
+
+    screen_info = cw->screen_info;
+    display_info = screen_info->display_info;
+    slices = screen_info->shadowSlices[cw->shadow_level];
+    g_return_if_fail (slices != NULL);
+
+    black = screen_info->blackPicture;
+    gsize = screen_info->gaussianSize;
+    x = cw->attr.x + cw->shadow_dx;
+    y = cw->attr.y + cw->shadow_dy;
+    w = cw->shadow_width;
+    h = cw->shadow_height;
+    mid_w = w - 2 * gsize;
+    mid_h = h - 2 * gsize;
+
+    /* Corners */
+    XRenderComposite (display_info->dpy, PictOpOver, black, slices->corners, dest,
+                      0, 0, 0, 0, x, y, gsize, gsize);
+    XRenderComposite (display_info->dpy, PictOpOver, black, slices->corners, dest,
+                      0, 0, gsize + 1, 0, x + w - gsize, y, gsize, gsize);
+    XRenderComposite (display_info->dpy, PictOpOver, black, slices->corners, dest,
+                      0, 0, 0, gsize + 1, x, y + h - gsize, gsize, gsize);
+    XRenderComposite (display_info->dpy, PictOpOver, black, slices->corners, dest,
+                      0, 0, gsize + 1, gsize + 1, x + w - gsize, y + h - gsize, gsize, gsize);
+
+    /* Top and bottom edges */
+    if (mid_w > 0)
+    {
+        XRenderComposite (display_info->dpy, PictOpOver, black, slices->columns, dest,
+                          0, 0, 0, 0, x + gsize, y, mid_w, gsize);
+        XRenderComposite (display_info->dpy, PictOpOver, black, slices->columns, dest,
+                          0, 0, 0, gsize + 1, x + gsize, y + h - gsize, mid_w, gsize);
+    }
+
+    /* Sides */
+    if (mid_h > 0)
+    {
+        XRenderComposite (display_info->dpy, PictOpOver, black, slices->rows, dest,
+                          0, 0, 0, 0, x, y + gsize, gsize, mid_h);
+        XRenderComposite (display_info->dpy, PictOpOver, black, slices->rows, dest,
+                          0, 0, gsize + 1, 0, x + w - gsize, y + gsize, gsize, mid_h);
+    }
+
+    /* Centre */
+    if ((mid_w > 0) && (mid_h > 0))
+    {
+        XRenderComposite (display_info->dpy, PictOpOver, black, slices->center, dest,
+                          0, 0, 0, 0, x + gsize, y + gsize, mid_w, mid_h);
+    }
+}
+
 static Picture
 solid_picture (ScreenInfo *screen_info, gboolean argb,
                gdouble a, gdouble r, gdouble g, gdouble b)
@@ -651,6 +1008,81 @@ solid_picture (ScreenInfo *screen_info, gboolean argb,
     return picture;
 }
 
+/*
+ * XserverRegion pool: creating and destroying regions costs a request each,
+ * reusing them from one frame to the next saves both. Every request going
+ * through here is accounted in region_requests.
+ */
+static XserverRegion
+region_new (ScreenInfo *screen_info, XRectangle *rects, gint nrects)
+{
+    DisplayInfo *display_info;
+    XserverRegion region;
+
+    display_info = screen_info->display_info;
+    screen_info->region_requests++;
+
+    if (screen_info->region_pool_count > 0)
+    {
+        region = screen_info->region_pool[--screen_info->region_pool_count];
+        XFixesSetRegion (display_info->dpy, region, rects, nrects);
+        return region;
+    }
+
+    return XFixesCreateRegion (display_info->dpy, rects, nrects);
+}
+
+/* The content of a scratch region is undefined, the caller must overwrite it */
+static XserverRegion
+region_scratch (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+
+    if (screen_info->region_pool_count > 0)
+    {
+        return screen_info->region_pool[--screen_info->region_pool_count];
+    }
+
+    display_info = screen_info->display_info;
+    screen_info->region_requests++;
+
+    return XFixesCreateRegion (display_info->dpy, NULL, 0);
+}
+
+static void
+region_release (ScreenInfo *screen_info, XserverRegion region)
+{
+    DisplayInfo *display_info;
+
+    if (region == None)
+    {
+        return;
+    }
+
+    if (screen_info->region_pool_count < REGION_POOL_SIZE)
+    {
+        screen_info->region_pool[screen_info->region_pool_count++] = region;
+        return;
+    }
+
+    display_info = screen_info->display_info;
+    screen_info->region_requests++;
+    XFixesDestroyRegion (display_info->dpy, region);
+}
+
+static void
+region_pool_free (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+
+    display_info = screen_info->display_info;
+    while (screen_info->region_pool_count > 0)
+    {
+        XFixesDestroyRegion (display_info->dpy,
+                             screen_info->region_pool[--screen_info->region_pool_count]);
+    }
+}
+
 static XserverRegion
 client_size (CWindow *cw)
 {
@@ -675,7 +1107,7 @@ client_size (CWindow *cw)
         r.y = frameY (c) + frameTop (c);
         r.width = frameWidth (c) - frameLeft (c) - frameRight (c);
         r.height = frameHeight (c) - frameTop (c) - frameBottom (c);
-        border = XFixesCreateRegion (display_info->dpy, &r, 1);
+        border = region_new (screen_info, &r, 1);
     }
 
     return border;
@@ -693,6 +1125,7 @@ border_size (CWindow *cw)
 
     screen_info = cw->screen_info;
     display_info = screen_info->display_info;
+    screen_info->region_requests++;
     border = XFixesCreateRegionFromWindow (display_info->dpy,
                                            cw->id, WindowRegionBounding);
     g_return_val_if_fail (border != None, None);
@@ -704,33 +1137,65 @@ border_size (CWindow *cw)
 }
 
 static void
-free_win_data (CWindow *cw, gboolean delete)
+free_window_pixmap (CWindow *cw)
 {
-    DisplayInfo *display_info;
     ScreenInfo *screen_info;
 
     screen_info = cw->screen_info;
-    display_info = screen_info->display_info;
 
 #if HAVE_NAME_WINDOW_PIXMAP
     if (cw->name_window_pixmap)
     {
-        XFreePixmap (display_info->dpy, cw->name_window_pixmap);
+        XFreePixmap (myScreenGetXDisplay (screen_info), cw->name_window_pixmap);
         cw->name_window_pixmap = None;
     }
 #endif
+    cw->picture_stale = FALSE;
+}
+
+/*
+ * After a resize, the named pixmap still holds the contents at the old
+ * size. Keep painting from it until the client has drawn at the new size,
+ * which is when it acks the XSync request or, failing that, reports damage.
+ */
+static gboolean
+is_picture_outdated (CWindow *cw)
+{
+    if (!cw->picture_stale)
+    {
+        return FALSE;
+    }
+#ifdef HAVE_XSYNC
+    if ((cw->c) && (cw->c->xsync_enabled) && (cw->c->xsync_waiting))
+    {
+        return FALSE;
+    }
+#endif /* HAVE_XSYNC */
+    return cw->damaged_since_resize;
+}
+
+static void
+free_win_data (CWindow *cw, gboolean delete)
+{
+    DisplayInfo *display_info;
+    ScreenInfo *screen_info;
+
+    screen_info = cw->screen_info;
+    display_info = screen_info->display_info;
 
     if (cw->picture)
     {
         XRenderFreePicture (display_info->dpy, cw->picture);
         cw->picture = None;
     }
+    free_window_pixmap (cw);
 
     if (cw->shadow)
     {
         XRenderFreePicture (display_info->dpy, cw->shadow);
         cw->shadow = None;
     }
+    cw->shadow_level = -1;
 
     if (cw->alphaPict)
     {
@@ -752,25 +1217,25 @@ free_win_data (CWindow *cw, gboolean delete)
 
     if (cw->borderSize)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->borderSize);
+        region_release (screen_info, cw->borderSize);
         cw->borderSize = None;
     }
 
     if (cw->clientSize)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->clientSize);
+        region_release (screen_info, cw->clientSize);
         cw->clientSize = None;
     }
 
     if (cw->borderClip)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->borderClip);
+        region_release (screen_info, cw->borderClip);
         cw->borderClip = None;
     }
 
     if (cw->extents)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->extents);
+        region_release (screen_info, cw->extents);
         cw->extents = None;
     }
 
@@ -965,19 +1430,22 @@ win_extents (CWindow *cw)
               (!(WIN_IS_ARGB(cw) || WIN_IS_SHAPED(cw)))))
     {
         XRectangle sr;
+        double shadow_opacity;
 
         TRACE ("window 0x%lx has extents", cw->id);
         cw->shadow_dx = SHADOW_OFFSET_X + screen_info->params->shadow_delta_x;
         cw->shadow_dy = SHADOW_OFFSET_Y + screen_info->params->shadow_delta_y;
 
-        if (!(cw->shadow))
-        {
-            double shadow_opacity;
-            shadow_opacity = (double) screen_info->params->frame_opacity
-                           * (screen_info->params->shadow_opacity / 100.0)
-                           * cw->opacity
-                           / (NET_WM_OPAQUE * 100.0);
+        shadow_opacity = (double) screen_info->params->frame_opacity
+                       * (screen_info->params->shadow_opacity / 100.0)
+                       * cw->opacity
+                       / (NET_WM_OPAQUE * 100.0);
 
+        if (!set_shadow_slices (cw, shadow_opacity,
+                                cw->attr.width + 2 * cw->attr.border_width,
+                                cw->attr.height + 2 * cw->attr.border_width) &&
+            !(cw->shadow))
+        {
             cw->shadow = shadow_picture (screen_info, shadow_opacity,
                                          cw->attr.width + 2 * cw->attr.border_width,
                                          cw->attr.height + 2 * cw->attr.border_width,
@@ -1008,12 +1476,22 @@ win_extents (CWindow *cw)
             r.height = sr.y + sr.height - r.y;
         }
     }
-    else if (cw->shadow)
+    else
     {
-        XRenderFreePicture (display_info->dpy, cw->shadow);
-        cw->shadow = None;
+        if (cw->shadow)
+        {
+            XRenderFreePicture (display_info->dpy, cw->shadow);
+            cw->shadow = None;
+        }
+        cw->shadow_level = -1;
     }
-    return XFixesCreateRegion (display_info->dpy, &r, 1);
+
+    cw->extents_bounds.x = r.x;
+    cw->extents_bounds.y = r.y;
+    cw->extents_bounds.width = r.width;
+    cw->extents_bounds.height = r.height;
+
+    return region_new (screen_info, &r, 1);
 }
 
 static void
@@ -1209,9 +1687,9 @@ paint_win (CWindow *cw, XserverRegion region, gboolean solid_part)
             r.y = frame_y + frame_top;
             r.width = frame_width - frame_left - frame_right;
             r.height = frame_height - frame_top - frame_bottom;
-            client_region = XFixesCreateRegion (display_info->dpy, &r, 1);
+            client_region = region_new (screen_info, &r, 1);
             XFixesSubtractRegion (display_info->dpy, region, region, client_region);
-            XFixesDestroyRegion (display_info->dpy, client_region);
+            region_release (screen_info, client_region);
         }
         else if (!solid_part)
         {
@@ -1248,6 +1726,8 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
 {
     DisplayInfo *display_info;
     XserverRegion paint_region;
+    XserverRegion shadowClip;
+    GdkRectangle screen, bounds;
     Display *dpy;
     GList *list;
     gint screen_width;
@@ -1270,7 +1750,7 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
     }
 
     /* Copy the original given region */
-    paint_region = XFixesCreateRegion (dpy, NULL, 0);
+    paint_region = region_scratch (screen_info);
     XFixesCopyRegion (dpy, paint_region, region);
 
     /* Set clipping to the given region */
@@ -1298,6 +1778,13 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
             continue;
         }
 
+        if (cw->occluded)
+        {
+            TRACE ("skipped, occluded 0x%lx", cw->id);
+            cw->skipped = TRUE;
+            continue;
+        }
+
         if ((cw->attr.x + cw->attr.width < 1) || (cw->attr.y + cw->attr.height < 1) ||
             (cw->attr.x >= screen_width) || (cw->attr.y >= screen_height))
         {
@@ -1318,6 +1805,13 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
         {
             cw->clientSize = client_size (cw);
         }
+        if (is_picture_outdated (cw))
+        {
+            TRACE ("rebuilding picture of resized window 0x%lx", cw->id);
+            XRenderFreePicture (dpy, cw->picture);
+            cw->picture = None;
+            free_window_pixmap (cw);
+        }
         if (cw->picture == None)
         {
             cw->picture = get_window_picture (cw);
@@ -1326,11 +1820,12 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
         {
             paint_win (cw, paint_region, TRUE);
         }
+        /* The region is kept from one frame to the next, only its content changes */
         if (cw->borderClip == None)
         {
-            cw->borderClip = XFixesCreateRegion (dpy, NULL, 0);
-            XFixesCopyRegion (dpy, cw->borderClip, paint_region);
+            cw->borderClip = region_scratch (screen_info);
         }
+        XFixesCopyRegion (dpy, cw->borderClip, paint_region);
 
         cw->skipped = FALSE;
     }
@@ -1345,12 +1840,10 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
     /*
      * Painting from bottom to top, translucent windows and shadows are painted now...
      */
-    for (list = g_list_last(screen_info->cwindows); list; list = g_list_previous (list))
+    shadowClip = None;
+    for (list = screen_info->cwindows_tail; list; list = g_list_previous (list))
     {
-        XserverRegion shadowClip;
-
         cw = (CWindow *) list->data;
-        shadowClip = None;
         TRACE ("painting backward 0x%lx", cw->id);
 
         if (cw->skipped)
@@ -1359,17 +1852,28 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
             continue;
         }
 
-        if (cw->shadow)
+        if (WIN_HAS_SHADOW(cw))
         {
-            shadowClip = XFixesCreateRegion(dpy, NULL, 0);
+            /* One scratch region is enough for all the shadows of the frame */
+            if (shadowClip == None)
+            {
+                shadowClip = region_scratch (screen_info);
+            }
             XFixesSubtractRegion (dpy, shadowClip, cw->borderClip, cw->borderSize);
 
             XFixesSetPictureClipRegion (dpy, screen_info->rootBuffer, 0, 0, shadowClip);
-            XRenderComposite (dpy, PictOpOver, screen_info->blackPicture, cw->shadow,
-                              screen_info->rootBuffer, 0, 0, 0, 0,
-                              cw->attr.x + cw->shadow_dx,
-                              cw->attr.y + cw->shadow_dy,
-                              cw->shadow_width, cw->shadow_height);
+            if (cw->shadow)
+            {
+                XRenderComposite (dpy, PictOpOver, screen_info->blackPicture, cw->shadow,
+                                  screen_info->rootBuffer, 0, 0, 0, 0,
+                                  cw->attr.x + cw->shadow_dx,
+                                  cw->attr.y + cw->shadow_dy,
+                                  cw->shadow_width, cw->shadow_height);
+            }
+            else
+            {
+                paint_shadow_slices (cw, screen_info->rootBuffer);
+            }
         }
 
         if (cw->picture)
@@ -1386,25 +1890,27 @@ paint_all (ScreenInfo *screen_info, XserverRegion region)
             XFixesSetPictureClipRegion (dpy, screen_info->rootBuffer, 0, 0, cw->borderClip);
             paint_win (cw, paint_region, FALSE);
         }
-
-        if (shadowClip)
-        {
-            XFixesDestroyRegion (dpy, shadowClip);
-        }
-
-        if (cw->borderClip)
-        {
-            XFixesDestroyRegion (dpy, cw->borderClip);
-            cw->borderClip = None;
-        }
     }
 
+    region_release (screen_info, shadowClip);
+
     TRACE ("Copying data back to screen");
-    /* Set clipping back to the given region */
-    XFixesSetPictureClipRegion (dpy, screen_info->rootBuffer, 0, 0, region);
-    XRenderComposite (dpy, PictOpSrc, screen_info->rootBuffer, None, screen_info->rootPicture,
-                      0, 0, 0, 0, 0, 0, screen_width, screen_height);
-    XFixesDestroyRegion (dpy, paint_region);
+    /*
+     * The root buffer persists from one frame to the next and only the
+     * damaged parts were repainted, so only the bounds of the damage kept
+     * by add_damage () are copied back, still clipped to the region.
+     */
+    screen.x = 0;
+    screen.y = 0;
+    screen.width = screen_width;
+    screen.height = screen_height;
+    if (gdk_rectangle_intersect (&screen_info->damage_bounds, &screen, &bounds))
+    {
+        XFixesSetPictureClipRegion (dpy, screen_info->rootBuffer, 0, 0, region);
+        XRenderComposite (dpy, PictOpSrc, screen_info->rootBuffer, None, screen_info->rootPicture,
+                          bounds.x, bounds.y, 0, 0, bounds.x, bounds.y, bounds.width, bounds.height);
+    }
+    region_release (screen_info, paint_region);
 }
 
 #if TIMEOUT_REPAINT
@@ -1419,104 +1925,214 @@ remove_timeouts (ScreenInfo *screen_info)
 }
 #endif /* TIMEOUT_REPAINT */
 
-static void
-repair_screen (ScreenInfo *screen_info)
+static gint64
+get_time_usec (void)
 {
-    DisplayInfo *display_info;
+    /* Wall clock changes must not skew the frame costs and intervals */
+#if GLIB_CHECK_VERSION(2, 28, 0)
+    return g_get_monotonic_time ();
+#elif defined (CLOCK_MONOTONIC)
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_nsec / 1000;
+#else
+    GTimeVal now;
 
-    g_return_if_fail (screen_info);
-    TRACE ("entering repair_screen");
+    g_get_current_time (&now);
+    return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
 
-    if (!screen_info->compositor_active)
+#if defined (HAVE_RANDR) && ((RANDR_MAJOR > 1) || (RANDR_MINOR >= 3))
+/*
+ * Fastest refresh rate among the active CRTCs, from the current screen
+ * resources which, unlike XRRGetScreenInfo (), never re-probe the outputs.
+ */
+static gint
+get_crtc_refresh_rate (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+    XRRScreenResources *resources;
+    XRRCrtcInfo *crtc;
+    XRRModeInfo *mode;
+    gint rate, i, j;
+
+    display_info = screen_info->display_info;
+    rate = 0;
+    resources = XRRGetScreenResourcesCurrent (display_info->dpy, screen_info->xroot);
+    if (resources == NULL)
     {
-        return;
+        return 0;
     }
 
-#if TIMEOUT_REPAINT
-    remove_timeouts (screen_info);
-#endif /* TIMEOUT_REPAINT */
-
-    display_info = screen_info->display_info;
-    if (screen_info->allDamage != None)
+    for (i = 0; i < resources->ncrtc; i++)
     {
-        paint_all (screen_info, screen_info->allDamage);
-        XFixesDestroyRegion (display_info->dpy, screen_info->allDamage);
-        screen_info->allDamage = None;
+        crtc = XRRGetCrtcInfo (display_info->dpy, resources, resources->crtcs[i]);
+        if (crtc == NULL)
+        {
+            continue;
+        }
+        for (j = 0; (crtc->mode != None) && (j < resources->nmode); j++)
+        {
+            mode = &resources->modes[j];
+            if ((mode->id == crtc->mode) && (mode->hTotal) && (mode->vTotal))
+            {
+                rate = MAX (rate, (gint) ((gdouble) mode->dotClock /
+                                          ((gdouble) mode->hTotal * mode->vTotal) + 0.5));
+                break;
+            }
+        }
+        XRRFreeCrtcInfo (crtc);
     }
+    XRRFreeScreenResources (resources);
+
+    return rate;
 }
+#endif /* HAVE_RANDR && RANDR >= 1.3 */
 
-#if TIMEOUT_REPAINT
-static gboolean
-compositor_timeout_cb (gpointer data)
+static void
+update_frame_interval (ScreenInfo *screen_info)
 {
-    ScreenInfo *screen_info;
+    DisplayInfo *display_info;
+    gint rate;
 
-    screen_info = (ScreenInfo *) data;
-    screen_info->compositor_timeout_id = 0;
-    repair_screen (screen_info);
+    display_info = screen_info->display_info;
+    rate = screen_info->params->refresh_rate;
+#if defined (HAVE_RANDR) && ((RANDR_MAJOR > 1) || (RANDR_MINOR >= 3))
+    if ((rate <= 0) && (display_info->have_xrandr) && (display_info->xrandr_version >= 1003))
+    {
+        rate = get_crtc_refresh_rate (screen_info);
+    }
+#endif /* HAVE_RANDR && RANDR >= 1.3 */
+    if (rate <= 0)
+    {
+        rate = REFRESH_RATE_FALLBACK;
+    }
 
-    return FALSE;
+    screen_info->frame_interval = G_USEC_PER_SEC / rate;
+    TRACE ("refresh rate %i Hz, frame interval %i usec", rate, screen_info->frame_interval);
 }
-#endif /* TIMEOUT_REPAINT */
 
 static void
-add_repair (ScreenInfo *screen_info)
+get_occlusion_bounds (CWindow *cw, GdkRectangle *rect, gboolean with_shadow)
 {
-#if TIMEOUT_REPAINT
-    if (screen_info->compositor_timeout_id != 0)
+    GdkRectangle shadow;
+
+    rect->x = cw->attr.x;
+    rect->y = cw->attr.y;
+    rect->width = cw->attr.width + 2 * cw->attr.border_width;
+    rect->height = cw->attr.height + 2 * cw->attr.border_width;
+
+    if (with_shadow && WIN_HAS_SHADOW(cw))
     {
-        return;
+        shadow.x = cw->attr.x + cw->shadow_dx;
+        shadow.y = cw->attr.y + cw->shadow_dy;
+        shadow.width = cw->shadow_width;
+        shadow.height = cw->shadow_height;
+        gdk_rectangle_union (rect, &shadow, rect);
     }
-    screen_info->compositor_timeout_id =
-        g_timeout_add (TIMEOUT_REPAINT,
-                       compositor_timeout_cb, screen_info);
-#endif /* TIMEOUT_REPAINT */
 }
 
-#if TIMEOUT_REPAINT == 0
-static void
-repair_display (DisplayInfo *display_info)
+static gboolean
+get_opaque_bounds (CWindow *cw, GdkRectangle *rect)
 {
-    GSList *screens;
+    ScreenInfo *screen_info;
 
-    g_return_if_fail (display_info);
-    TRACE ("entering repair_display");
+    /* Only what the forward pass of paint_all () paints solid can hide other windows */
+    if (!WIN_IS_VISIBLE(cw) || !WIN_IS_DAMAGED(cw) || !WIN_IS_REDIRECTED(cw) ||
+        !WIN_IS_OPAQUE(cw) || WIN_IS_SHAPED(cw))
+    {
+        return FALSE;
+    }
 
-    for (screens = display_info->screens; screens; screens = g_slist_next (screens))
+    screen_info = cw->screen_info;
+    if (WIN_HAS_FRAME(cw) && (screen_info->params->frame_opacity < 100))
     {
-        repair_screen ((ScreenInfo *) screens->data);
+        rect->x = frameX (cw->c) + frameLeft (cw->c);
+        rect->y = frameY (cw->c) + frameTop (cw->c);
+        rect->width = frameWidth (cw->c) - frameLeft (cw->c) - frameRight (cw->c);
+        rect->height = frameHeight (cw->c) - frameTop (cw->c) - frameBottom (cw->c);
     }
+    else
+    {
+        rect->x = cw->attr.x;
+        rect->y = cw->attr.y;
+        rect->width = cw->attr.width + 2 * cw->attr.border_width;
+        rect->height = cw->attr.height + 2 * cw->attr.border_width;
+    }
+
+    return ((rect->width > 0) && (rect->height > 0));
 }
-#endif
 
+/*
+ * Walk the stack from top to bottom and flag the windows entirely covered
+ * by the opaque windows above them. Only runs after something that can
+ * change the result (stacking, geometry, opacity, shape) marked it dirty.
+ */
 static void
-add_damage (ScreenInfo *screen_info, XserverRegion damage)
+update_occlusion (ScreenInfo *screen_info)
 {
     DisplayInfo *display_info;
+    GdkRegion *opaque;
+    GdkRectangle rect;
+    GdkOverlapType overlap;
+    GList *list;
+    CWindow *cw;
+    gboolean occluded;
 
-    TRACE ("entering add_damage");
-
-    if (damage == None)
-    {
-        return;
-    }
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering update_occlusion");
 
     display_info = screen_info->display_info;
-    if (screen_info->allDamage != None)
-    {
-        XFixesUnionRegion (display_info->dpy,
-                           screen_info->allDamage,
-                           screen_info->allDamage,
-                           damage);
-        XFixesDestroyRegion (display_info->dpy, damage);
-    }
-    else
+    screen_info->occlusion_dirty = FALSE;
+    opaque = gdk_region_new ();
+
+    for (list = screen_info->cwindows; list; list = g_list_next (list))
     {
-        screen_info->allDamage = damage;
+        cw = (CWindow *) list->data;
+        overlap = GDK_OVERLAP_RECTANGLE_OUT;
+
+        /* Without extents, the shadow geometry may be stale */
+        if (WIN_IS_VIEWABLE(cw) && (cw->extents != None))
+        {
+            get_occlusion_bounds (cw, &rect, TRUE);
+            overlap = gdk_region_rect_in (opaque, &rect);
+        }
+        occluded = (overlap == GDK_OVERLAP_RECTANGLE_IN);
+
+        /* A shadow overlapping a neighbour doesn't make the window itself covered */
+        cw->partly_occluded = FALSE;
+        if (overlap == GDK_OVERLAP_RECTANGLE_PART)
+        {
+            get_occlusion_bounds (cw, &rect, FALSE);
+            cw->partly_occluded = (gdk_region_rect_in (opaque, &rect) != GDK_OVERLAP_RECTANGLE_OUT);
+        }
+
+        if (occluded != cw->occluded)
+        {
+            TRACE ("window 0x%lx is now %s", cw->id, occluded ? "occluded" : "visible");
+            cw->occluded = occluded;
+            if (!occluded && cw->damage_held)
+            {
+                /*
+                 * Whatever uncovered the window has damaged its area already,
+                 * just drop the held damage to get notified again.
+                 */
+                XDamageSubtract (display_info->dpy, cw->damage, None, None);
+                cw->damage_held = FALSE;
+                cw->damaged = TRUE;
+                cw->damaged_since_resize = TRUE;
+            }
+        }
+
+        if (!occluded && get_opaque_bounds (cw, &rect))
+        {
+            gdk_region_union_with_rect (opaque, &rect);
+        }
     }
 
-    /* The per-screen allDamage region is freed by repair_screen () */
-    add_repair (screen_info);
+    gdk_region_destroy (opaque);
 }
 
 static void
@@ -1565,28 +2181,32 @@ fix_region (CWindow *cw, XserverRegion region)
     }
 }
 
-static void
-repair_win (CWindow *cw, XRectangle *r)
+/*
+ * Take all the damage accumulated on the window so far, in screen
+ * coordinates, or None if there is nothing to repaint.
+ */
+static XserverRegion
+fetch_damage (CWindow *cw)
 {
     DisplayInfo *display_info;
     ScreenInfo *screen_info;
     XserverRegion parts;
 
-    g_return_if_fail (cw != NULL);
+    g_return_val_if_fail (cw != NULL, None);
 
-    TRACE ("entering repair_win");
+    TRACE ("entering fetch_damage");
     screen_info = cw->screen_info;
     display_info = screen_info->display_info;
 
     if (!(cw->damage))
     {
         /* Input Only have no damage */
-        return;
+        return None;
     }
 
     if (cw->damaged)
     {
-        parts = XFixesCreateRegion (display_info->dpy, NULL, 0);
+        parts = region_scratch (screen_info);
         /* Copy the damage region to parts, subtracting it from the window's damage */
         XDamageSubtract (display_info->dpy, cw->damage, None, parts);
         XFixesTranslateRegion (display_info->dpy, parts,
@@ -1600,13 +2220,313 @@ repair_win (CWindow *cw, XRectangle *r)
         XDamageSubtract (display_info->dpy, cw->damage, None, None);
     }
 
+    cw->damaged_since_resize = TRUE;
     if (parts)
     {
         fix_region (cw, parts);
-        /* parts region will be destroyed by add_damage () */
-        add_damage (cw->screen_info, parts);
-        cw->damaged = TRUE;
+        if (!cw->damaged)
+        {
+            /* The window gets painted from now on and may hide others */
+            screen_info->occlusion_dirty = TRUE;
+            cw->damaged = TRUE;
+        }
+    }
+
+    return parts;
+}
+
+/*
+ * Keep the bounds of the screen damage on our side as well, so that
+ * paint_all () can limit the copy back without fetching the region.
+ */
+static void
+add_damage_bounds (ScreenInfo *screen_info, GdkRectangle *rect)
+{
+    GdkRectangle *bounds;
+
+    if ((rect->width <= 0) || (rect->height <= 0))
+    {
+        return;
+    }
+
+    bounds = &screen_info->damage_bounds;
+    if ((bounds->width > 0) && (bounds->height > 0))
+    {
+        gdk_rectangle_union (bounds, rect, bounds);
+    }
+    else
+    {
+        *bounds = *rect;
+    }
+}
+
+static void
+merge_damage (ScreenInfo *screen_info, XserverRegion damage)
+{
+    DisplayInfo *display_info;
+
+    display_info = screen_info->display_info;
+    if (screen_info->allDamage != None)
+    {
+        XFixesUnionRegion (display_info->dpy,
+                           screen_info->allDamage,
+                           screen_info->allDamage,
+                           damage);
+        region_release (screen_info, damage);
+    }
+    else
+    {
+        screen_info->allDamage = damage;
+    }
+}
+
+/*
+ * Collect the damage of all windows queued since the last frame, with a
+ * single subtract per window however many events it sent, and fold it all
+ * into the screen damage at once.
+ */
+static void
+flush_damage (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+    XserverRegion damage, parts;
+    GdkRectangle rect;
+    GList *list;
+    CWindow *cw;
+
+    TRACE ("entering flush_damage");
+
+    if (screen_info->damage_queued == 0)
+    {
+        return;
+    }
+
+    display_info = screen_info->display_info;
+    damage = None;
+
+    for (list = screen_info->cwindows; list; list = g_list_next (list))
+    {
+        cw = (CWindow *) list->data;
+        if (!(cw->damage_queued))
+        {
+            continue;
+        }
+        cw->damage_queued = FALSE;
+
+        if (!WIN_IS_REDIRECTED(cw))
+        {
+            continue;
+        }
+
+        parts = fetch_damage (cw);
+        if (parts == None)
+        {
+            continue;
+        }
+
+        /* Window contents, or its whole extents on first paint */
+        get_occlusion_bounds (cw, &rect, FALSE);
+        add_damage_bounds (screen_info, &rect);
+        add_damage_bounds (screen_info, &cw->extents_bounds);
+
+        if (damage != None)
+        {
+            XFixesUnionRegion (display_info->dpy, damage, damage, parts);
+            region_release (screen_info, parts);
+        }
+        else
+        {
+            damage = parts;
+        }
+    }
+
+    TRACE ("flushed damage of %u windows from %u events",
+           screen_info->damage_queued, screen_info->damage_events);
+    screen_info->damage_queued = 0;
+    screen_info->damage_events = 0;
+
+    if (damage != None)
+    {
+        merge_damage (screen_info, damage);
+    }
+}
+
+static void
+repair_screen (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+    gint64 start, cost;
+
+    g_return_if_fail (screen_info);
+    TRACE ("entering repair_screen");
+
+    if (!screen_info->compositor_active)
+    {
+        return;
+    }
+
+    if (screen_info->compositor_hold)
+    {
+        TRACE ("repaint on hold, keeping damages for later");
+        return;
+    }
+
+#if TIMEOUT_REPAINT
+    remove_timeouts (screen_info);
+#endif /* TIMEOUT_REPAINT */
+
+    display_info = screen_info->display_info;
+    flush_damage (screen_info);
+    if (screen_info->allDamage != None)
+    {
+        if (screen_info->occlusion_dirty)
+        {
+            update_occlusion (screen_info);
+        }
+        start = get_time_usec ();
+        paint_all (screen_info, screen_info->allDamage);
+        region_release (screen_info, screen_info->allDamage);
+        screen_info->allDamage = None;
+        screen_info->damage_bounds.width = 0;
+        screen_info->damage_bounds.height = 0;
+
+        /* Keep a running average of what a frame costs us */
+        cost = get_time_usec () - start;
+        screen_info->frame_cost = (screen_info->frame_cost * 7 + (gint) cost) / 8;
+        screen_info->frame_last_paint = start;
+        screen_info->frames_painted++;
+        screen_info->region_requests_frame = screen_info->region_requests;
+        screen_info->region_requests = 0;
+
+        if ((screen_info->frames_painted % FRAME_STATS_INTERVAL) == 0)
+        {
+            DBG ("screen %i: %u frames, %u immediate, %u aligned, cost %i usec, interval %i usec, "
+                 "%u region requests last frame, %u damage events throttled",
+                 screen_info->screen, screen_info->frames_painted,
+                 screen_info->frames_immediate, screen_info->frames_aligned,
+                 screen_info->frame_cost, screen_info->frame_interval,
+                 screen_info->region_requests_frame,
+                 screen_info->damage_throttled);
+        }
+    }
+}
+
+#if TIMEOUT_REPAINT
+static gboolean
+compositor_timeout_cb (gpointer data)
+{
+    ScreenInfo *screen_info;
+
+    screen_info = (ScreenInfo *) data;
+    screen_info->compositor_timeout_id = 0;
+    repair_screen (screen_info);
+
+    return FALSE;
+}
+#endif /* TIMEOUT_REPAINT */
+
+/*
+   Schedule the next frame. When nothing was painted for a whole frame
+   interval, paint as soon as the pending events are processed. Otherwise
+   wait for the next interval, minus what a frame usually costs, so that
+   bursts of damage are folded into one paint per refresh.
+ */
+static void
+add_repair (ScreenInfo *screen_info)
+{
+#if TIMEOUT_REPAINT
+    gint64 elapsed;
+    gint delay;
+
+    if (screen_info->compositor_timeout_id != 0)
+    {
+        return;
+    }
+
+    if (screen_info->frame_interval <= 0)
+    {
+        update_frame_interval (screen_info);
+    }
+
+    elapsed = get_time_usec () - screen_info->frame_last_paint;
+    if ((elapsed < 0) || (elapsed >= screen_info->frame_interval))
+    {
+        delay = 0;
+        screen_info->frames_immediate++;
+    }
+    else
+    {
+        delay = screen_info->frame_interval - (gint) elapsed - screen_info->frame_cost;
+        delay = MAX (delay, 0);
+        screen_info->frames_aligned++;
+    }
+    TRACE ("scheduling repaint in %i usec (elapsed %i, cost %i)",
+           delay, (gint) elapsed, screen_info->frame_cost);
+
+    screen_info->compositor_timeout_id =
+        g_timeout_add (delay / 1000,
+                       compositor_timeout_cb, screen_info);
+#endif /* TIMEOUT_REPAINT */
+}
+
+#if TIMEOUT_REPAINT == 0
+static void
+repair_display (DisplayInfo *display_info)
+{
+    GSList *screens;
+
+    g_return_if_fail (display_info);
+    TRACE ("entering repair_display");
+
+    for (screens = display_info->screens; screens; screens = g_slist_next (screens))
+    {
+        repair_screen ((ScreenInfo *) screens->data);
+    }
+}
+#endif
+
+static void
+add_damage (ScreenInfo *screen_info, XserverRegion damage, GdkRectangle *bounds)
+{
+    GdkRectangle screen;
+
+    TRACE ("entering add_damage");
+
+    if (damage == None)
+    {
+        return;
+    }
+
+    /* Without bounds, assume the whole screen may be damaged */
+    if (bounds == NULL)
+    {
+        screen.x = 0;
+        screen.y = 0;
+        screen.width = screen_info->width;
+        screen.height = screen_info->height;
+        bounds = &screen;
     }
+    add_damage_bounds (screen_info, bounds);
+
+    /* The per-screen allDamage region is freed by repair_screen () */
+    merge_damage (screen_info, damage);
+    add_repair (screen_info);
+}
+
+static void
+queue_damage (CWindow *cw)
+{
+    ScreenInfo *screen_info;
+
+    screen_info = cw->screen_info;
+    screen_info->damage_events++;
+    if (!(cw->damage_queued))
+    {
+        cw->damage_queued = TRUE;
+        screen_info->damage_queued++;
+    }
+    /* The damage itself is fetched by flush_damage () before painting */
+    add_repair (screen_info);
 }
 
 static void
@@ -1621,9 +2541,10 @@ damage_screen (ScreenInfo *screen_info)
     r.y = 0;
     r.width = screen_info->width;
     r.height = screen_info->height;
-    region = XFixesCreateRegion (display_info->dpy, &r, 1);
+    region = region_new (screen_info, &r, 1);
     /* region will be freed by add_damage () */
-    add_damage (screen_info, region);
+    add_damage (screen_info, region, NULL);
+    screen_info->occlusion_dirty = TRUE;
 }
 
 static void
@@ -1637,7 +2558,7 @@ damage_win (CWindow *cw)
     extents = win_extents (cw);
     fix_region (cw, extents);
     /* extents region will be freed by add_damage () */
-    add_damage (cw->screen_info, extents);
+    add_damage (cw->screen_info, extents, &cw->extents_bounds);
 }
 
 static void
@@ -1659,7 +2580,7 @@ update_extents (CWindow *cw)
 
     if (cw->extents)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->extents);
+        region_release (screen_info, cw->extents);
         cw->extents = None;
     }
 }
@@ -1689,65 +2610,310 @@ determine_mode (CWindow *cw)
 
     if (cw->alphaBorderPict)
     {
-        XRenderFreePicture (display_info->dpy, cw->alphaBorderPict);
-        cw->alphaBorderPict = None;
+        XRenderFreePicture (display_info->dpy, cw->alphaBorderPict);
+        cw->alphaBorderPict = None;
+    }
+
+    format = XRenderFindVisualFormat (display_info->dpy, cw->attr.visual);
+    cw->argb = ((format) && (format->type == PictTypeDirect) && (format->direct.alphaMask));
+    screen_info->occlusion_dirty = TRUE;
+
+    if (cw->extents)
+    {
+        XserverRegion damage;
+
+        damage = region_scratch (screen_info);
+        XFixesCopyRegion (display_info->dpy, damage, cw->extents);
+        fix_region (cw, damage);
+        /* damage region will be destroyed by add_damage () */
+        add_damage (screen_info, damage, &cw->extents_bounds);
+    }
+}
+
+static void
+expose_area (ScreenInfo *screen_info, XRectangle *rects, gint nrects)
+{
+    DisplayInfo *display_info;
+    XserverRegion region;
+    GdkRectangle bounds, rect;
+    gint i;
+
+    g_return_if_fail (rects != NULL);
+    g_return_if_fail (nrects > 0);
+    TRACE ("entering expose_area");
+
+    display_info = screen_info->display_info;
+    bounds.x = rects[0].x;
+    bounds.y = rects[0].y;
+    bounds.width = rects[0].width;
+    bounds.height = rects[0].height;
+    for (i = 1; i < nrects; i++)
+    {
+        rect.x = rects[i].x;
+        rect.y = rects[i].y;
+        rect.width = rects[i].width;
+        rect.height = rects[i].height;
+        gdk_rectangle_union (&bounds, &rect, &bounds);
+    }
+    region = region_new (screen_info, rects, nrects);
+    /* region will be destroyed by add_damage () */
+    add_damage (screen_info, region, &bounds);
+}
+
+static void
+set_win_opacity (CWindow *cw, guint opacity)
+{
+    DisplayInfo *display_info;
+    ScreenInfo *screen_info;
+
+    g_return_if_fail (cw != NULL);
+    TRACE ("entering set_win_opacity");
+
+    screen_info = cw->screen_info;
+    display_info = screen_info->display_info;
+
+    cw->opacity = opacity;
+    determine_mode(cw);
+    if (WIN_HAS_SHADOW(cw))
+    {
+        if (cw->shadow)
+        {
+            XRenderFreePicture (display_info->dpy, cw->shadow);
+            cw->shadow = None;
+        }
+        if (cw->extents)
+        {
+            region_release (screen_info, cw->extents);
+        }
+        cw->extents = win_extents (cw);
+        add_repair (screen_info);
+    }
+}
+
+static void
+account_unredirected_win (CWindow *cw)
+{
+    ScreenInfo *screen_info;
+    DisplayInfo *display_info;
+
+    screen_info = cw->screen_info;
+    display_info = screen_info->display_info;
+
+    cw->fulloverlay = is_fullscreen(cw);
+    if (cw->fulloverlay)
+    {
+        /*
+         * To be safe, we only count the fullscreen un-redirected windows.
+         * We do not want a smaller override redirect such as a tooltip
+         * for example to prevent the overlay to be remapped and leave
+         * a black screen until the tooltip is unmapped...
+         */
+        screen_info->wins_unredirected++;
+        TRACE ("Mapping fullscreen window 0x%lx, wins_unredirected increased to %i", cw->id, screen_info->wins_unredirected);
+    }
+    TRACE ("Mapping unredirected window 0x%lx, wins_unredirected is now %i", cw->id, screen_info->wins_unredirected);
+#if HAVE_OVERLAYS
+    if ((screen_info->wins_unredirected == 1) && (display_info->have_overlays))
+    {
+        TRACE ("Unmapping overlay window");
+        XUnmapWindow (myScreenGetXDisplay (screen_info), screen_info->overlay);
+    }
+#endif /* HAVE_OVERLAYS */
+}
+
+static void
+redirect_win (CWindow *cw)
+{
+    ScreenInfo *screen_info;
+    DisplayInfo *display_info;
+
+    g_return_if_fail (cw != NULL);
+    TRACE ("entering redirect_win");
+
+    if (WIN_IS_REDIRECTED(cw))
+    {
+        return;
+    }
+
+    screen_info = cw->screen_info;
+    display_info = screen_info->display_info;
+
+    XCompositeRedirectWindow (display_info->dpy, cw->id, display_info->composite_mode);
+    cw->redirected = TRUE;
+
+    /* Damage left over from the unredirected time would keep the server quiet */
+    if (cw->damage)
+    {
+        XDamageSubtract (display_info->dpy, cw->damage, None, None);
+    }
+    cw->damaged = FALSE;
+    screen_info->occlusion_dirty = TRUE;
+
+    if (cw->fulloverlay)
+    {
+        cw->fulloverlay = FALSE;
+        screen_info->wins_unredirected--;
+        TRACE ("Window 0x%lx redirected, wins_unredirected decreased to %i", cw->id, screen_info->wins_unredirected);
+        if (!screen_info->wins_unredirected)
+        {
+#if HAVE_OVERLAYS
+            if (display_info->have_overlays)
+            {
+                TRACE ("Remapping overlay window");
+                XMapWindow (myScreenGetXDisplay (screen_info), screen_info->overlay);
+            }
+#endif /* HAVE_OVERLAYS */
+            damage_screen (screen_info);
+        }
+    }
+}
+
+/*
+ * Find the first entry of a rule list naming the class or the name of the
+ * window, entries are "class" or "class:value". Returns the value part of
+ * the entry, an empty string if it has none, or NULL if nothing matched.
+ */
+static const gchar *
+match_class_rule (CWindow *cw, gchar **rules)
+{
+    DisplayInfo *display_info;
+    XClassHint class_hint;
+    const gchar *res_name;
+    const gchar *res_class;
+    const gchar *value;
+    const gchar *sep;
+    gchar **rule;
+    gsize len;
+
+    if (rules == NULL)
+    {
+        return NULL;
+    }
+
+    display_info = cw->screen_info->display_info;
+    class_hint.res_name = NULL;
+    class_hint.res_class = NULL;
+    if (cw->c)
+    {
+        res_name = cw->c->class.res_name;
+        res_class = cw->c->class.res_class;
+    }
+    else
+    {
+        XGetClassHint (display_info->dpy, cw->id, &class_hint);
+        res_name = class_hint.res_name;
+        res_class = class_hint.res_class;
+    }
+
+    value = NULL;
+    for (rule = rules; *rule; rule++)
+    {
+        sep = strchr (*rule, ':');
+        len = (sep) ? (gsize) (sep - *rule) : strlen (*rule);
+        if (len == 0)
+        {
+            continue;
+        }
+
+        if (((res_class) && (strlen (res_class) == len) && !g_ascii_strncasecmp (*rule, res_class, len)) ||
+            ((res_name) && (strlen (res_name) == len) && !g_ascii_strncasecmp (*rule, res_name, len)))
+        {
+            value = (sep) ? sep + 1 : "";
+            break;
+        }
+    }
+
+    if (class_hint.res_name)
+    {
+        XFree (class_hint.res_name);
+    }
+    if (class_hint.res_class)
+    {
+        XFree (class_hint.res_class);
     }
 
-    format = XRenderFindVisualFormat (display_info->dpy, cw->attr.visual);
-    cw->argb = ((format) && (format->type == PictTypeDirect) && (format->direct.alphaMask));
+    return value;
+}
 
-    if (cw->extents)
-    {
-        XserverRegion damage;
+static gint
+get_bypass_rule (CWindow *cw)
+{
+    const gchar *policy;
 
-        damage = XFixesCreateRegion (display_info->dpy, NULL, 0);
-        XFixesCopyRegion (display_info->dpy, damage, cw->extents);
-        fix_region (cw, damage);
-        /* damage region will be destroyed by add_damage () */
-        add_damage (screen_info, damage);
+    policy = match_class_rule (cw, cw->screen_info->params->unredirect_rules);
+    if (policy == NULL)
+    {
+        return BYPASS_NONE;
+    }
+    if (!g_ascii_strcasecmp ("bypass", policy))
+    {
+        return BYPASS_UNREDIRECT;
+    }
+    if (!g_ascii_strcasecmp ("composite", policy))
+    {
+        return BYPASS_REDIRECT;
     }
+    return BYPASS_NONE;
 }
 
 static void
-expose_area (ScreenInfo *screen_info, XRectangle *rects, gint nrects)
+update_bypass (CWindow *cw)
 {
     DisplayInfo *display_info;
-    XserverRegion region;
+    Window w;
+    gint bypass;
 
-    g_return_if_fail (rects != NULL);
-    g_return_if_fail (nrects > 0);
-    TRACE ("entering expose_area");
+    display_info = cw->screen_info->display_info;
 
-    display_info = screen_info->display_info;
-    region = XFixesCreateRegion (display_info->dpy, rects, nrects);
-    /* region will be destroyed by add_damage () */
-    add_damage (screen_info, region);
+    /* The user's rules take precedence over what the application asks for */
+    cw->bypass = get_bypass_rule (cw);
+    if (cw->bypass != BYPASS_NONE)
+    {
+        return;
+    }
+
+    w = (cw->c) ? cw->c->window : cw->id;
+    if (getBypassCompositor (display_info, w, &bypass) &&
+        ((bypass == BYPASS_UNREDIRECT) || (bypass == BYPASS_REDIRECT)))
+    {
+        cw->bypass = bypass;
+    }
 }
 
 static void
-set_win_opacity (CWindow *cw, guint opacity)
+update_priority (CWindow *cw)
 {
-    DisplayInfo *display_info;
-    ScreenInfo *screen_info;
-
-    g_return_if_fail (cw != NULL);
-    TRACE ("entering set_win_opacity");
+    cw->low_priority =
+        (match_class_rule (cw, cw->screen_info->params->throttle_classes) != NULL);
+}
 
-    screen_info = cw->screen_info;
-    display_info = screen_info->display_info;
+/*
+ * Apply the bypass policy to a mapped window. Windows asking to bypass the
+ * compositor are unredirected only while they cover their monitor, as
+ * anything smaller would end up hidden below the overlay.
+ */
+static void
+update_redirection (CWindow *cw)
+{
+    if (!WIN_IS_VIEWABLE(cw) || !WIN_HAS_DAMAGE(cw))
+    {
+        return;
+    }
 
-    cw->opacity = opacity;
-    determine_mode(cw);
-    if (cw->shadow)
+    if (WIN_IS_REDIRECTED(cw))
     {
-        XRenderFreePicture (display_info->dpy, cw->shadow);
-        cw->shadow = None;
-        if (cw->extents)
+        if ((cw->bypass == BYPASS_UNREDIRECT) && !WIN_IS_SHAPED(cw) && is_fullscreen(cw))
         {
-            XFixesDestroyRegion (display_info->dpy, cw->extents);
+            TRACE ("Window 0x%lx bypasses the compositor", cw->id);
+            unredirect_win (cw);
+            account_unredirected_win (cw);
         }
-        cw->extents = win_extents (cw);
-        add_repair (screen_info);
+    }
+    else if ((cw->bypass == BYPASS_REDIRECT) ||
+             ((cw->bypass == BYPASS_UNREDIRECT) && !is_fullscreen(cw)))
+    {
+        TRACE ("Window 0x%lx is composited again", cw->id);
+        redirect_win (cw);
     }
 }
 
@@ -1755,41 +2921,28 @@ static void
 map_win (CWindow *cw)
 {
     ScreenInfo *screen_info;
-    DisplayInfo *display_info;
 
     g_return_if_fail (cw != NULL);
     TRACE ("entering map_win 0x%lx", cw->id);
 
     screen_info = cw->screen_info;
-    display_info = screen_info->display_info;
 
     if (!WIN_IS_REDIRECTED(cw))
     {
-        cw->fulloverlay = is_fullscreen(cw);
-        if (cw->fulloverlay)
-        {
-            /*
-             * To be safe, we only count the fullscreen un-redirected windows.
-             * We do not want a smaller override redirect such as a tooltip
-             * for example to prevent the overlay to be remapped and leave
-             * a black screen until the tooltip is unmapped...
-             */
-            screen_info->wins_unredirected++;
-            TRACE ("Mapping fullscreen window 0x%lx, wins_unredirected increased to %i", cw->id, screen_info->wins_unredirected);
-        }
-        TRACE ("Mapping unredirected window 0x%lx, wins_unredirected is now %i", cw->id, screen_info->wins_unredirected);
-#if HAVE_OVERLAYS
-        if ((screen_info->wins_unredirected == 1) && (display_info->have_overlays))
-        {
-            TRACE ("Unmapping overlay window");
-            XUnmapWindow (myScreenGetXDisplay (screen_info), screen_info->overlay);
-        }
-#endif /* HAVE_OVERLAYS */
+        account_unredirected_win (cw);
         return;
     }
 
     cw->viewable = TRUE;
     cw->damaged = FALSE;
+    screen_info->occlusion_dirty = TRUE;
+
+    if (cw->bypass != BYPASS_NONE)
+    {
+        /* The application or the user made the decision for us */
+        update_redirection (cw);
+        return;
+    }
 
     /* Check for new windows to un-redirect. */
     if (WIN_HAS_DAMAGE(cw) && WIN_IS_OVERRIDE(cw) &&
@@ -1844,10 +2997,38 @@ unmap_win (CWindow *cw)
         damage_win (cw);
     }
 
+    if (!WIN_IS_REDIRECTED(cw))
+    {
+        /*
+         * The window is flagged redirected below, make the server agree,
+         * otherwise the next map names a pixmap for an unredirected window.
+         */
+        TRACE ("Redirecting unmapped window 0x%lx", cw->id);
+        XCompositeRedirectWindow (display_info->dpy, cw->id, display_info->composite_mode);
+        if (cw->damage)
+        {
+            XDamageSubtract (display_info->dpy, cw->damage, None, None);
+        }
+    }
+
+    if ((cw->damage_held) || (cw->damage_queued))
+    {
+        /* Otherwise no damage would be reported on the next map */
+        XDamageSubtract (display_info->dpy, cw->damage, None, None);
+        cw->damage_held = FALSE;
+        if (cw->damage_queued)
+        {
+            cw->damage_queued = FALSE;
+            screen_info->damage_queued--;
+        }
+    }
+
     cw->viewable = FALSE;
     cw->damaged = FALSE;
     cw->redirected = TRUE;
     cw->fulloverlay = FALSE;
+    cw->occluded = FALSE;
+    screen_info->occlusion_dirty = TRUE;
 
     free_win_data (cw, FALSE);
 }
@@ -1930,6 +3111,14 @@ add_win (DisplayInfo *display_info, Window id, Client *c)
         return;
     }
 
+    if (find_cwindow_in_screen (screen_info, id))
+    {
+        g_free (new);
+        myDisplayUngrabServer (display_info);
+        TRACE ("Window 0x%lx already added", id);
+        return;
+    }
+
     if (c == NULL)
     {
         /* We must be notified of property changes for transparency, even if the win is not managed */
@@ -1946,6 +3135,17 @@ add_win (DisplayInfo *display_info, Window id, Client *c)
     new->screen_info = screen_info;
     new->id = id;
     new->damaged = FALSE;
+    new->occluded = FALSE;
+    new->damage_held = FALSE;
+    new->damage_queued = FALSE;
+    new->bypass = BYPASS_NONE;
+    new->partly_occluded = FALSE;
+    new->low_priority = FALSE;
+    new->damage_events = 0;
+    new->damage_rate = 0;
+    new->damage_total = 0;
+    new->damage_period = 0;
+    new->last_repair = 0;
     new->redirected = TRUE;
     new->fulloverlay = FALSE;
     new->shaped = is_shaped (display_info, id);
@@ -1966,6 +3166,8 @@ add_win (DisplayInfo *display_info, Window id, Client *c)
 #if HAVE_NAME_WINDOW_PIXMAP
     new->name_window_pixmap = None;
 #endif
+    new->picture_stale = FALSE;
+    new->damaged_since_resize = FALSE;
     new->picture = None;
     new->alphaPict = None;
     new->alphaBorderPict = None;
@@ -1973,18 +3175,27 @@ add_win (DisplayInfo *display_info, Window id, Client *c)
     new->borderSize = None;
     new->clientSize = None;
     new->extents = None;
+    new->extents_bounds.width = 0;
+    new->extents_bounds.height = 0;
     new->shadow = None;
     new->shadow_dx = 0;
     new->shadow_dy = 0;
     new->shadow_width = 0;
     new->shadow_height = 0;
+    new->shadow_level = -1;
     new->borderClip = None;
 
     init_opacity (new);
     determine_mode (new);
+    update_bypass (new);
+    update_priority (new);
 
     /* Insert window at top of stack */
-    screen_info->cwindows = g_list_prepend (screen_info->cwindows, new);
+    new->link = g_list_alloc ();
+    new->link->data = new;
+    stack_insert_above (screen_info, new,
+                        screen_info->cwindows ? (CWindow *) screen_info->cwindows->data : NULL);
+    g_hash_table_insert (screen_info->cwindow_hash, (gpointer) id, new);
 
     if (WIN_IS_VISIBLE(new))
     {
@@ -2000,52 +3211,42 @@ static void
 restack_win (CWindow *cw, Window above)
 {
     ScreenInfo *screen_info;
-    Window previous_above;
-    GList *sibling;
+    CWindow *sibling;
     GList *next;
 
     g_return_if_fail (cw != NULL);
     TRACE ("entering restack_win, 0x%lx above 0x%lx", cw->id, above);
 
     screen_info = cw->screen_info;
-    sibling = g_list_find (screen_info->cwindows, (gconstpointer) cw);
-    next = g_list_next (sibling);
-    previous_above = None;
-
-    if (next)
-    {
-        CWindow *ncw = (CWindow *) next;
-        previous_above = ncw->id;
-    }
+    next = g_list_next (cw->link);
 
     /* If above is set to None, the window whose state was changed is on
      * the bottom of the stack with respect to sibling.
      */
     if (above == None)
     {
-        /* Insert at bottom of window stack */
-        screen_info->cwindows = g_list_delete_link (screen_info->cwindows, sibling);
-        screen_info->cwindows = g_list_append (screen_info->cwindows, cw);
+        if (next == NULL)
+        {
+            return;
+        }
+        sibling = NULL;
     }
-    else if (previous_above != above)
+    else
     {
-        GList *list;
-
-        for (list = screen_info->cwindows; list; list = g_list_next (list))
+        if ((next) && (((CWindow *) next->data)->id == above))
         {
-            CWindow *cw2 = (CWindow *) list->data;
-            if (cw2->id == above)
-            {
-                break;
-            }
+            return;
         }
-
-        if (list != NULL)
+        sibling = find_cwindow_in_screen (screen_info, above);
+        if ((sibling == NULL) || (sibling == cw))
         {
-            screen_info->cwindows = g_list_delete_link (screen_info->cwindows, sibling);
-            screen_info->cwindows = g_list_insert_before (screen_info->cwindows, list, cw);
+            return;
         }
     }
+
+    stack_unlink (screen_info, cw);
+    stack_insert_above (screen_info, cw, sibling);
+    screen_info->occlusion_dirty = TRUE;
 }
 
 static void
@@ -2065,32 +3266,38 @@ resize_win (CWindow *cw, gint x, gint y, gint width, gint height, gint bw)
 
     if (WIN_IS_VISIBLE(cw))
     {
-        damage = XFixesCreateRegion (display_info->dpy, NULL, 0);
+        damage = region_new (screen_info, NULL, 0);
         if (cw->extents)
         {
             XFixesCopyRegion (display_info->dpy, damage, cw->extents);
+            add_damage_bounds (screen_info, &cw->extents_bounds);
         }
     }
 
     if (cw->extents)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->extents);
+        region_release (screen_info, cw->extents);
         cw->extents = None;
     }
 
     if ((cw->attr.width != width) || (cw->attr.height != height))
     {
 #if HAVE_NAME_WINDOW_PIXMAP
-        if (cw->name_window_pixmap)
+        if ((cw->picture) && (cw->name_window_pixmap))
         {
-            XFreePixmap (display_info->dpy, cw->name_window_pixmap);
-            cw->name_window_pixmap = None;
+            /* paint_all () rebuilds it once the client has caught up */
+            cw->picture_stale = TRUE;
+            cw->damaged_since_resize = FALSE;
         }
+        else
 #endif
-        if (cw->picture)
         {
-            XRenderFreePicture (display_info->dpy, cw->picture);
-            cw->picture = None;
+            if (cw->picture)
+            {
+                XRenderFreePicture (display_info->dpy, cw->picture);
+                cw->picture = None;
+            }
+            free_window_pixmap (cw);
         }
 
         if (cw->shadow)
@@ -2105,15 +3312,16 @@ resize_win (CWindow *cw, gint x, gint y, gint width, gint height, gint bw)
     {
         if (cw->borderSize)
         {
-            XFixesDestroyRegion (display_info->dpy, cw->borderSize);
+            region_release (screen_info, cw->borderSize);
             cw->borderSize = None;
         }
 
         if (cw->clientSize)
         {
-            XFixesDestroyRegion (display_info->dpy, cw->clientSize);
+            region_release (screen_info, cw->clientSize);
             cw->clientSize = None;
         }
+        screen_info->occlusion_dirty = TRUE;
     }
 
     cw->attr.x = x;
@@ -2129,7 +3337,13 @@ resize_win (CWindow *cw, gint x, gint y, gint width, gint height, gint bw)
 
         fix_region (cw, damage);
         /* damage region will be destroyed by add_damage () */
-        add_damage (screen_info, damage);
+        add_damage (screen_info, damage, &cw->extents_bounds);
+    }
+
+    if (cw->bypass != BYPASS_NONE)
+    {
+        /* Going in or out of fullscreen changes what bypassing means */
+        update_redirection (cw);
     }
 }
 
@@ -2150,16 +3364,17 @@ reshape_win (CWindow *cw)
 
     if (WIN_IS_VISIBLE(cw))
     {
-        damage = XFixesCreateRegion (display_info->dpy, NULL, 0);
+        damage = region_new (screen_info, NULL, 0);
         if (cw->extents)
         {
             XFixesCopyRegion (display_info->dpy, damage, cw->extents);
+            add_damage_bounds (screen_info, &cw->extents_bounds);
         }
     }
 
     if (cw->extents)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->extents);
+        region_release (screen_info, cw->extents);
         cw->extents = None;
     }
 
@@ -2171,28 +3386,30 @@ reshape_win (CWindow *cw)
 
     if (cw->borderSize)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->borderSize);
+        region_release (screen_info, cw->borderSize);
         cw->borderSize = None;
     }
 
     if (cw->clientSize)
     {
-        XFixesDestroyRegion (display_info->dpy, cw->clientSize);
+        region_release (screen_info, cw->clientSize);
         cw->clientSize = None;
     }
 
+    screen_info->occlusion_dirty = TRUE;
+
     if (damage)
     {
         cw->extents = win_extents (cw);
         XFixesUnionRegion (display_info->dpy, damage, damage, cw->extents);
 
         /* A shape notify will likely change the shadows too, so clear the extents */
-        XFixesDestroyRegion (display_info->dpy, cw->extents);
+        region_release (screen_info, cw->extents);
         cw->extents = None;
 
         fix_region (cw, damage);
         /* damage region will be destroyed by add_damage () */
-        add_damage (screen_info, damage);
+        add_damage (screen_info, damage, &cw->extents_bounds);
     }
 }
 
@@ -2215,17 +3432,100 @@ destroy_win (DisplayInfo *display_info, Window id)
             unmap_win (cw);
         }
         screen_info = cw->screen_info;
-        screen_info->cwindows = g_list_remove (screen_info->cwindows, (gconstpointer) cw);
+        g_hash_table_remove (screen_info->cwindow_hash, (gconstpointer) cw->id);
+        stack_unlink (screen_info, cw);
+        g_list_free_1 (cw->link);
+        cw->link = NULL;
+        screen_info->occlusion_dirty = TRUE;
 
         free_win_data (cw, TRUE);
     }
 }
 
+static void
+account_damage (CWindow *cw, gint64 now)
+{
+    gint64 elapsed;
+
+    cw->damage_events++;
+    cw->damage_total++;
+
+    elapsed = now - cw->damage_period;
+    if (elapsed >= G_USEC_PER_SEC)
+    {
+        cw->damage_rate = (guint) (cw->damage_events * G_USEC_PER_SEC / elapsed);
+        cw->damage_events = 0;
+        cw->damage_period = now;
+    }
+}
+
+static gboolean
+is_throttled (CWindow *cw)
+{
+    /* Only managed windows other than the focused one get throttled */
+    if ((cw->c == NULL) || (cw->c == clientGetFocus ()))
+    {
+        return FALSE;
+    }
+
+    return ((cw->low_priority) ||
+            (cw->partly_occluded) ||
+            (cw->damage_rate >= THROTTLE_DAMAGE_RATE));
+}
+
+static gboolean
+throttle_timeout_cb (gpointer data)
+{
+    ScreenInfo *screen_info;
+    GList *list;
+    CWindow *cw;
+    gint64 now;
+
+    screen_info = (ScreenInfo *) data;
+    screen_info->throttle_timeout_id = 0;
+    now = get_time_usec ();
+
+    for (list = screen_info->cwindows; list; list = g_list_next (list))
+    {
+        cw = (CWindow *) list->data;
+        /* Occluded windows get their damage back once uncovered */
+        if ((cw->damage_held) && !(cw->occluded))
+        {
+            cw->damage_held = FALSE;
+            queue_damage (cw);
+            cw->last_repair = now;
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+throttle_damage (CWindow *cw)
+{
+    ScreenInfo *screen_info;
+
+    screen_info = cw->screen_info;
+
+    /* Keep the damage pending, the server won't send more until we subtract it */
+    TRACE ("throttling damage for window 0x%lx (%u events/s, %u total)",
+           cw->id, cw->damage_rate, cw->damage_total);
+    cw->damage_held = TRUE;
+    screen_info->damage_throttled++;
+
+    if (screen_info->throttle_timeout_id == 0)
+    {
+        screen_info->throttle_timeout_id =
+            g_timeout_add (THROTTLE_INTERVAL, throttle_timeout_cb, screen_info);
+    }
+}
+
 static void
 compositorHandleDamage (DisplayInfo *display_info, XDamageNotifyEvent *ev)
 {
     ScreenInfo *screen_info;
     CWindow *cw;
+    gint64 now;
 
     g_return_if_fail (display_info != NULL);
     g_return_if_fail (ev != NULL);
@@ -2242,7 +3542,33 @@ compositorHandleDamage (DisplayInfo *display_info, XDamageNotifyEvent *ev)
     if ((cw) && WIN_IS_REDIRECTED(cw))
     {
         screen_info = cw->screen_info;
-        repair_win (cw, &ev->area);
+        if (screen_info->occlusion_dirty)
+        {
+            update_occlusion (screen_info);
+        }
+        if (cw->occluded)
+        {
+            /*
+             * Leave the damage pending, the server won't report any more
+             * for this window until it's subtracted once uncovered.
+             */
+            TRACE ("holding damage for occluded window 0x%lx", cw->id);
+            cw->damage_held = TRUE;
+        }
+        else
+        {
+            now = get_time_usec ();
+            account_damage (cw, now);
+            if (is_throttled (cw) && (now - cw->last_repair < THROTTLE_INTERVAL * 1000))
+            {
+                throttle_damage (cw);
+            }
+            else
+            {
+                queue_damage (cw);
+                cw->last_repair = now;
+            }
+        }
         screen_info->damages_pending = ev->more;
     }
 }
@@ -2334,6 +3660,26 @@ compositorHandlePropertyNotify (DisplayInfo *display_info, XPropertyEvent *ev)
             }
         }
     }
+    else if (ev->atom == display_info->atoms[NET_WM_BYPASS_COMPOSITOR])
+    {
+        CWindow *cw = find_cwindow_in_display (display_info, ev->window);
+        TRACE ("Bypass compositor property changed for id 0x%lx", ev->window);
+
+        if (!cw)
+        {
+            /* Managed clients set the property on their own window, not the frame */
+            Client *c = myDisplayGetClientFromWindow (display_info, ev->window, SEARCH_WINDOW);
+            if (c)
+            {
+                cw = find_cwindow_in_display (display_info, c->frame);
+            }
+        }
+        if (cw)
+        {
+            update_bypass (cw);
+            update_redirection (cw);
+        }
+    }
     else
     {
         TRACE ("No compositor property changed for id 0x%lx", ev->window);
@@ -2410,7 +3756,7 @@ compositorHandleCirculateNotify (DisplayInfo *display_info, XCirculateEvent *ev)
     }
 
     first = cw->screen_info->cwindows;
-    top = (CWindow *) first;
+    top = (first) ? (CWindow *) first->data : NULL;
 
     if ((ev->place == PlaceOnTop) && (top))
     {
@@ -2622,6 +3968,8 @@ compositorSetClient (DisplayInfo *display_info, Window id, Client *c)
         {
             update_extents (cw);
             cw->c = c;
+            update_bypass (cw);
+            update_priority (cw);
         }
         return TRUE;
     }
@@ -2957,10 +4305,29 @@ compositorManageScreen (ScreenInfo *screen_info)
                                                0.0  /* blue  */);
     screen_info->rootTile = None;
     screen_info->allDamage = None;
+    screen_info->damage_bounds.width = 0;
+    screen_info->damage_bounds.height = 0;
     screen_info->cwindows = NULL;
+    screen_info->cwindows_tail = NULL;
+    screen_info->cwindow_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
     screen_info->compositor_active = TRUE;
     screen_info->wins_unredirected = 0;
+    screen_info->occlusion_dirty = TRUE;
     screen_info->compositor_timeout_id = 0;
+    screen_info->compositor_hold = FALSE;
+    screen_info->frame_last_paint = 0;
+    screen_info->frame_cost = 0;
+    screen_info->frames_painted = 0;
+    screen_info->frames_immediate = 0;
+    screen_info->frames_aligned = 0;
+    screen_info->region_pool_count = 0;
+    screen_info->region_requests = 0;
+    screen_info->region_requests_frame = 0;
+    screen_info->throttle_timeout_id = 0;
+    screen_info->damage_throttled = 0;
+    screen_info->damage_queued = 0;
+    screen_info->damage_events = 0;
+    update_frame_interval (screen_info);
     screen_info->damages_pending = FALSE;
 
     XClearArea (display_info->dpy, screen_info->output, 0, 0, 0, 0, TRUE);
@@ -3000,6 +4367,11 @@ compositorUnmanageScreen (ScreenInfo *screen_info)
 #if TIMEOUT_REPAINT
     remove_timeouts (screen_info);
 #endif /* TIMEOUT_REPAINT */
+    if (screen_info->throttle_timeout_id != 0)
+    {
+        g_source_remove (screen_info->throttle_timeout_id);
+        screen_info->throttle_timeout_id = 0;
+    }
 
     i = 0;
     for (list = screen_info->cwindows; list; list = g_list_next (list))
@@ -3010,8 +4382,17 @@ compositorUnmanageScreen (ScreenInfo *screen_info)
     }
     g_list_free (screen_info->cwindows);
     screen_info->cwindows = NULL;
+    screen_info->cwindows_tail = NULL;
+    g_hash_table_destroy (screen_info->cwindow_hash);
+    screen_info->cwindow_hash = NULL;
     TRACE ("Compositor: removed %i window(s) remaining", i);
 
+    region_release (screen_info, screen_info->allDamage);
+    screen_info->allDamage = None;
+    screen_info->damage_bounds.width = 0;
+    screen_info->damage_bounds.height = 0;
+    region_pool_free (screen_info);
+
 #if HAVE_OVERLAYS
     if (display_info->have_overlays)
     {
@@ -3034,6 +4415,8 @@ compositorUnmanageScreen (ScreenInfo *screen_info)
         screen_info->blackPicture = None;
     }
 
+    free_shadow_slices (screen_info);
+
     if (screen_info->shadowTop)
     {
         g_free (screen_info->shadowTop);
@@ -3158,10 +4541,72 @@ compositorUpdateScreenSize (ScreenInfo *screen_info)
         XRenderFreePicture (display_info->dpy, screen_info->rootBuffer);
         screen_info->rootBuffer = None;
     }
+    /* The mode, hence the refresh rate, may have changed too */
+    update_frame_interval (screen_info);
     damage_screen (screen_info);
 #endif /* HAVE_COMPOSITOR */
 }
 
+void
+compositorUpdateRefreshRate (ScreenInfo *screen_info)
+{
+#ifdef HAVE_COMPOSITOR
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering compositorUpdateRefreshRate");
+
+    if (!compositorIsUsable (screen_info->display_info))
+    {
+        return;
+    }
+    update_frame_interval (screen_info);
+#endif /* HAVE_COMPOSITOR */
+}
+
+void
+compositorUpdateUnredirectRules (ScreenInfo *screen_info)
+{
+#ifdef HAVE_COMPOSITOR
+    GList *list;
+    CWindow *cw;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering compositorUpdateUnredirectRules");
+
+    if (!compositorIsUsable (screen_info->display_info))
+    {
+        return;
+    }
+
+    for (list = screen_info->cwindows; list; list = g_list_next (list))
+    {
+        cw = (CWindow *) list->data;
+        update_bypass (cw);
+        update_redirection (cw);
+    }
+#endif /* HAVE_COMPOSITOR */
+}
+
+void
+compositorUpdateThrottleClasses (ScreenInfo *screen_info)
+{
+#ifdef HAVE_COMPOSITOR
+    GList *list;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering compositorUpdateThrottleClasses");
+
+    if (!compositorIsUsable (screen_info->display_info))
+    {
+        return;
+    }
+
+    for (list = screen_info->cwindows; list; list = g_list_next (list))
+    {
+        update_priority ((CWindow *) list->data);
+    }
+#endif /* HAVE_COMPOSITOR */
+}
+
 void
 compositorWindowSetOpacity (DisplayInfo *display_info, Window id, guint opacity)
 {
@@ -3185,6 +4630,31 @@ compositorWindowSetOpacity (DisplayInfo *display_info, Window id, guint opacity)
 #endif /* HAVE_COMPOSITOR */
 }
 
+/*
+   Hold repaints while several windows are being reconfigured so that
+   intermediate states never reach the screen, damages accumulate and
+   are painted at once when released.
+ */
+void
+compositorHoldRepaint (ScreenInfo *screen_info, gboolean hold)
+{
+#ifdef HAVE_COMPOSITOR
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering compositorHoldRepaint (%s)", hold ? "hold" : "release");
+
+    if (screen_info->compositor_hold == hold)
+    {
+        return;
+    }
+    screen_info->compositor_hold = hold;
+
+    if (!hold)
+    {
+        repair_screen (screen_info);
+    }
+#endif /* HAVE_COMPOSITOR */
+}
+
 void
 compositorRebuildScreen (ScreenInfo *screen_info)
 {
@@ -63,10 +63,15 @@ void                     compositorAddAllWindows                (ScreenInfo *);
 gboolean                 compositorActivateScreen               (ScreenInfo *,
                                                                  gboolean);
 void                     compositorUpdateScreenSize             (ScreenInfo *);
+void                     compositorUpdateRefreshRate            (ScreenInfo *);
+void                     compositorUpdateUnredirectRules        (ScreenInfo *);
+void                     compositorUpdateThrottleClasses        (ScreenInfo *);
 
 void                     compositorWindowSetOpacity             (DisplayInfo *,
                                                                  Window,
                                                                  guint);
+void                     compositorHoldRepaint                  (ScreenInfo *,
+                                                                 gboolean);
 void                     compositorRebuildScreen                (ScreenInfo *);
 gboolean                 compositorTestServer                   (DisplayInfo *);
 
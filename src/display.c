@@ -111,6 +111,7 @@ myDisplayInitAtoms (DisplayInfo *display_info)
         "_NET_WM_ACTION_SHADE",
         "_NET_WM_ACTION_STICK",
         "_NET_WM_ALLOWED_ACTIONS",
+        "_NET_WM_BYPASS_COMPOSITOR",
         "_NET_WM_CONTEXT_HELP",
         "_NET_WM_DESKTOP",
         "_NET_WM_FULLSCREEN_MONITORS",
@@ -189,6 +190,30 @@ myDisplayInitAtoms (DisplayInfo *display_info)
                           FALSE, display_info->atoms) != 0);
 }
 
+/*
+ * A window may be shared by several clients (typically a user time
+ * window), so each hash entry holds a list of references, each with
+ * the SEARCH_* roles the window plays for that client.
+ */
+typedef struct _ClientWindowRef ClientWindowRef;
+struct _ClientWindowRef
+{
+    Client *c;
+    unsigned short role;
+};
+
+static void
+myDisplayFreeClientWindows (gpointer data)
+{
+    GSList *list;
+
+    for (list = (GSList *) data; list; list = g_slist_next (list))
+    {
+        g_free (list->data);
+    }
+    g_slist_free ((GSList *) data);
+}
+
 static void
 myDisplayCreateTimestampWin (DisplayInfo *display_info)
 {
@@ -293,11 +318,18 @@ myDisplayInit (GdkDisplay *gdisplay)
 #endif /* HAVE_RENDER */
 
 #ifdef HAVE_RANDR
+    major = 0;
+    minor = 0;
+    display->xrandr_version = 0;
     if (XRRQueryExtension (display->dpy,
                             &display->xrandr_event_base,
                             &display->xrandr_error_base))
     {
         display->have_xrandr = TRUE;
+        if (XRRQueryVersion (display->dpy, &major, &minor))
+        {
+            display->xrandr_version = major * 1000 + minor;
+        }
     }
     else
     {
@@ -338,6 +370,8 @@ myDisplayInit (GdkDisplay *gdisplay)
     display->xfilter = NULL;
     display->screens = NULL;
     display->clients = NULL;
+    display->client_windows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                     NULL, myDisplayFreeClientWindows);
     display->xgrabcount = 0;
     display->double_click_time = 250;
     display->double_click_distance = 5;
@@ -385,6 +419,9 @@ myDisplayClose (DisplayInfo *display)
     g_slist_free (display->clients);
     display->clients = NULL;
 
+    g_hash_table_destroy (display->client_windows);
+    display->client_windows = NULL;
+
     g_slist_free (display->screens);
     display->screens = NULL;
 
@@ -510,12 +547,14 @@ myDisplayGetClientFromWindow (DisplayInfo *display, Window w, unsigned short mod
     g_return_val_if_fail (w != None, NULL);
     g_return_val_if_fail (display != NULL, NULL);
 
-    for (list = display->clients; list; list = g_slist_next (list))
+    list = g_hash_table_lookup (display->client_windows, (gconstpointer) w);
+    for (; list; list = g_slist_next (list))
     {
-        Client *c = (Client *) list->data;
-        if (clientGetFromWindow (c, w, mode))
+        ClientWindowRef *ref = (ClientWindowRef *) list->data;
+        if (ref->role & mode)
         {
-            return (c);
+            TRACE ("found \"%s\" (role 0x%x)", ref->c->name, ref->role);
+            return (ref->c);
         }
     }
     TRACE ("no client found");
@@ -523,6 +562,76 @@ myDisplayGetClientFromWindow (DisplayInfo *display, Window w, unsigned short mod
     return NULL;
 }
 
+void
+myDisplayAddClientWindow (DisplayInfo *display, Window w, Client *c, unsigned short role)
+{
+    ClientWindowRef *ref;
+    GSList *list, *head;
+
+    g_return_if_fail (c != NULL);
+    g_return_if_fail (display != NULL);
+
+    if (w == None)
+    {
+        return;
+    }
+
+    head = g_hash_table_lookup (display->client_windows, (gconstpointer) w);
+    for (list = head; list; list = g_slist_next (list))
+    {
+        ref = (ClientWindowRef *) list->data;
+        if (ref->c == c)
+        {
+            ref->role |= role;
+            return;
+        }
+    }
+
+    ref = g_new0 (ClientWindowRef, 1);
+    ref->c = c;
+    ref->role = role;
+    /* g_hash_table_replace() would free the list we are extending */
+    g_hash_table_steal (display->client_windows, (gconstpointer) w);
+    g_hash_table_insert (display->client_windows, (gpointer) w,
+                         g_slist_append (head, ref));
+}
+
+void
+myDisplayRemoveClientWindow (DisplayInfo *display, Window w, Client *c, unsigned short role)
+{
+    ClientWindowRef *ref;
+    GSList *list, *head;
+
+    g_return_if_fail (c != NULL);
+    g_return_if_fail (display != NULL);
+
+    if (w == None)
+    {
+        return;
+    }
+
+    head = g_hash_table_lookup (display->client_windows, (gconstpointer) w);
+    for (list = head; list; list = g_slist_next (list))
+    {
+        ref = (ClientWindowRef *) list->data;
+        if (ref->c == c)
+        {
+            ref->role &= ~role;
+            if (ref->role == 0)
+            {
+                head = g_slist_delete_link (head, list);
+                g_free (ref);
+                g_hash_table_steal (display->client_windows, (gconstpointer) w);
+                if (head)
+                {
+                    g_hash_table_insert (display->client_windows, (gpointer) w, head);
+                }
+            }
+            return;
+        }
+    }
+}
+
 void
 myDisplayAddScreen (DisplayInfo *display, ScreenInfo *screen)
 {
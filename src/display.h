@@ -83,7 +83,8 @@ enum
     SEARCH_WINDOW         = (1 << 0),
     SEARCH_FRAME          = (1 << 1),
     SEARCH_BUTTON         = (1 << 2),
-    SEARCH_WIN_USER_TIME  = (1 << 3)
+    SEARCH_WIN_USER_TIME  = (1 << 3),
+    SEARCH_DECORATION     = (1 << 4)
 };
 
 enum
@@ -205,6 +206,7 @@ enum
     NET_WM_ACTION_SHADE,
     NET_WM_ACTION_STICK,
     NET_WM_ALLOWED_ACTIONS,
+    NET_WM_BYPASS_COMPOSITOR,
     NET_WM_CONTEXT_HELP,
     NET_WM_DESKTOP,
     NET_WM_FULLSCREEN_MONITORS,
@@ -284,6 +286,11 @@ typedef struct _xfwmPixmap        xfwmPixmap;
 typedef struct _XfwmParams        XfwmParams;
 typedef struct _ScreenInfo        ScreenInfo;
 typedef struct _Settings          Settings;
+typedef struct _SpatialGrid       SpatialGrid;
+typedef struct _TileLayout        TileLayout;
+typedef struct _TileNode          TileNode;
+typedef struct _TileZones         TileZones;
+typedef struct _TileEdge          TileEdge;
 
 struct _DisplayInfo
 {
@@ -305,6 +312,7 @@ struct _DisplayInfo
     eventFilterSetup *xfilter;
     GSList *screens;
     GSList *clients;
+    GHashTable *client_windows;
 
     gboolean have_shape;
     gboolean have_render;
@@ -329,6 +337,7 @@ struct _DisplayInfo
 #ifdef HAVE_RANDR
     gint xrandr_error_base;
     gint xrandr_event_base;
+    gint xrandr_version;
 #endif /* HAVE_RANDR */
 #ifdef HAVE_XSYNC
     gint xsync_event_base;
@@ -377,6 +386,14 @@ void                     myDisplayRemoveClient                  (DisplayInfo *,
 Client                  *myDisplayGetClientFromWindow           (DisplayInfo *,
                                                                  Window,
                                                                  unsigned short);
+void                     myDisplayAddClientWindow               (DisplayInfo *,
+                                                                 Window,
+                                                                 Client *,
+                                                                 unsigned short);
+void                     myDisplayRemoveClientWindow            (DisplayInfo *,
+                                                                 Window,
+                                                                 Client *,
+                                                                 unsigned short);
 void                     myDisplayAddScreen                     (DisplayInfo *,
                                                                  ScreenInfo *);
 void                     myDisplayRemoveScreen                  (DisplayInfo *,
@@ -62,6 +62,7 @@
 #include "compositor.h"
 #include "events.h"
 #include "event_filter.h"
+#include "tiling.h"
 #include "xsync.h"
 
 #ifndef CHECK_BUTTON_TIME
@@ -285,7 +286,32 @@ toggle_show_desktop (ScreenInfo *screen_info)
 static eventFilterStatus
 handleMotionNotify (DisplayInfo *display_info, XMotionEvent * ev)
 {
+    Client *c;
+    int part;
+
     TRACE ("entering handleMotionNotify");
+
+    /* Frames drawn on a single window get the resize cursors by hit testing */
+    c = myDisplayGetClientFromWindow (display_info, ev->window, SEARCH_FRAME);
+    if ((c) && FLAG_TEST (c->xfwm_flags, XFWM_FLAG_SINGLE_FRAME)
+        && (ev->subwindow == MYWINDOW_XWINDOW (c->decoration)))
+    {
+        part = frameGetPartAt (c, ev->x, ev->y);
+        if (part != c->pointer_part)
+        {
+            c->pointer_part = part;
+            if ((part != FRAME_PART_NONE) && (part != FRAME_PART_TITLE))
+            {
+                XDefineCursor (display_info->dpy, MYWINDOW_XWINDOW (c->decoration),
+                               myDisplayGetCursorResize (display_info, part));
+            }
+            else
+            {
+                XUndefineCursor (display_info->dpy, MYWINDOW_XWINDOW (c->decoration));
+            }
+        }
+    }
+
     return EVENT_FILTER_REMOVE;
 }
 
@@ -856,6 +882,7 @@ handleButtonPress (DisplayInfo *display_info, XButtonEvent * ev)
     Client *c;
     Window win;
     guint state, part;
+    int hit;
     gboolean replay;
 
     TRACE ("entering handleButtonPress");
@@ -891,6 +918,28 @@ handleButtonPress (DisplayInfo *display_info, XButtonEvent * ev)
             clientSwitchApp ();
         }
 #endif
+        else if (ev->window == c->window)
+        {
+            /*
+               Checked first, clicks in the client may have no subwindow, which
+               would match the decoration windows not created in single frame mode.
+             */
+            replay = TRUE;
+            clientPassGrabMouseButton (c);
+            if (((screen_info->params->raise_with_any_button) && (c->type & WINDOW_REGULAR_FOCUSABLE)) || (ev->button == Button1))
+            {
+                if (!(c->type & WINDOW_TYPE_DONT_FOCUS))
+                {
+                    clientSetFocus (screen_info, c, ev->time, NO_FOCUS_FLAG);
+                }
+                if ((screen_info->params->raise_on_click) ||
+                    !FLAG_TEST (c->xfwm_flags, XFWM_FLAG_HAS_BORDER))
+                {
+                    clientClearDelayedRaise ();
+                    clientRaise (c, None);
+                }
+            }
+        }
         else if (WIN_IS_BUTTON (win))
         {
             if (ev->button <= Button3)
@@ -907,6 +956,20 @@ handleButtonPress (DisplayInfo *display_info, XButtonEvent * ev)
                 clientButtonPress (c, win, ev);
             }
         }
+        else if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_SINGLE_FRAME)
+                 && (win == MYWINDOW_XWINDOW (c->decoration)))
+        {
+            /* All decorations are on the same window, find out which part was hit */
+            hit = frameGetPartAt (c, ev->x, ev->y);
+            if (hit == FRAME_PART_TITLE)
+            {
+                titleButton (c, state, ev);
+            }
+            else if ((hit != FRAME_PART_NONE) && (state == 0))
+            {
+                edgeButton (c, hit, ev);
+            }
+        }
         else if (win == MYWINDOW_XWINDOW (c->title))
         {
             titleButton (c, state, ev);
@@ -992,24 +1055,6 @@ handleButtonPress (DisplayInfo *display_info, XButtonEvent * ev)
         {
             edgeButton (c, CORNER_COUNT + SIDE_RIGHT, ev);
         }
-        else if (ev->window == c->window)
-        {
-            replay = TRUE;
-            clientPassGrabMouseButton (c);
-            if (((screen_info->params->raise_with_any_button) && (c->type & WINDOW_REGULAR_FOCUSABLE)) || (ev->button == Button1))
-            {
-                if (!(c->type & WINDOW_TYPE_DONT_FOCUS))
-                {
-                    clientSetFocus (screen_info, c, ev->time, NO_FOCUS_FLAG);
-                }
-                if ((screen_info->params->raise_on_click) ||
-                    !FLAG_TEST (c->xfwm_flags, XFWM_FLAG_HAS_BORDER))
-                {
-                    clientClearDelayedRaise ();
-                    clientRaise (c, None);
-                }
-            }
-        }
     }
     else
     {
@@ -2169,6 +2214,8 @@ handleShape (DisplayInfo *display_info, XShapeEvent * ev)
         }
         else if (ev->kind == ShapeBounding)
         {
+            /* The frame shape follows the client's */
+            frameClearShapeCache (c);
             if ((ev->shaped) && !FLAG_TEST (c->flags, CLIENT_FLAG_HAS_SHAPE))
             {
                 update = TRUE;
@@ -2237,6 +2284,7 @@ handleXSyncAlarmNotify (DisplayInfo *display_info, XSyncAlarmNotifyEvent * ev)
         c->xsync_waiting = FALSE;
         c->xsync_value = ev->counter_value;
         clientXSyncClearTimeout (c);
+        clientConfigureAck (c);
     }
 
     return EVENT_FILTER_REMOVE;
@@ -2764,6 +2812,7 @@ refresh_font_cb (GObject * obj, GdkEvent * ev, gpointer data)
     g_return_val_if_fail (screen_info, TRUE);
 
     myScreenUpdateFontHeight (screen_info);
+    frameFlushTitleCache (screen_info);
     clientUpdateAllFrames (screen_info, UPDATE_FRAME);
     return (TRUE);
 }
@@ -2799,6 +2848,7 @@ size_changed_cb(GdkScreen *gscreen, gpointer data)
     if (size_changed)
     {
         myScreenInvalidateMonitorCache (screen_info);
+        tilingInvalidateZones (screen_info);
 
         setNetWorkarea (display_info, screen_info->xroot, screen_info->workspace_count,
                         screen_info->width, screen_info->height, screen_info->margins);
@@ -2848,6 +2898,7 @@ monitors_changed_cb(GdkScreen *gscreen, gpointer data)
     previous_num_monitors = screen_info->num_monitors;
     myScreenInvalidateMonitorCache (screen_info);
     myScreenRebuildMonitorIndex (screen_info);
+    tilingInvalidateZones (screen_info);
     size_changed = myScreenComputeSize (screen_info);
 
     if (size_changed || (screen_info->num_monitors != previous_num_monitors))
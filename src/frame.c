@@ -25,6 +25,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 #include <gdk/gdk.h>
 #include <gdk/gdkx.h>
@@ -39,12 +41,37 @@
 #include "frame.h"
 #include "compositor.h"
 
+/* Number of rendered titles kept per screen */
+#ifndef TITLE_CACHE_SIZE
+#define TITLE_CACHE_SIZE 32
+#endif /* TITLE_CACHE_SIZE */
+
+/* Granularity of the single decoration pixmap, which is reused while the frame fits */
+#ifndef DECORATION_PIXMAP_STEP
+#define DECORATION_PIXMAP_STEP 256
+#endif /* DECORATION_PIXMAP_STEP */
+
+#define DECORATION_PIXMAP_SIZE(s) \
+    ((((s) + DECORATION_PIXMAP_STEP - 1) / DECORATION_PIXMAP_STEP) * DECORATION_PIXMAP_STEP)
+
 typedef struct
 {
     xfwmPixmap pm_title;
     xfwmPixmap pm_sides[SIDE_COUNT];
 } FramePixmap;
 
+typedef struct
+{
+    gchar *name;
+    gint state;
+    gint width;
+    gint height;
+    gint left;
+    gint right;
+    xfwmPixmap pm_title;
+    xfwmPixmap pm_top;
+} TitleCacheEntry;
+
 
 int
 frameDecorationLeft (ScreenInfo *screen_info)
@@ -487,6 +514,90 @@ frameCreateTitlePixmap (Client * c, int state, int left, int right, xfwmPixmap *
     g_object_unref (G_OBJECT (layout));
 }
 
+static void
+frameFreeTitleCacheEntry (TitleCacheEntry *entry)
+{
+    xfwmPixmapFree (&entry->pm_title);
+    xfwmPixmapFree (&entry->pm_top);
+    g_free (entry->name);
+    g_free (entry);
+}
+
+/*
+ * Same as frameCreateTitlePixmap () but the title is looked up first among
+ * the ones rendered already, for this window or any other one with the same
+ * name and geometry. The returned pixmaps belong to the cache, they must
+ * not be freed by the caller.
+ */
+static void
+frameGetTitlePixmap (Client * c, int state, int left, int right, xfwmPixmap * title_pm, xfwmPixmap * top_pm)
+{
+    ScreenInfo *screen_info;
+    TitleCacheEntry *entry;
+    GList *list;
+    gint width, height;
+
+    TRACE ("entering frameGetTitlePixmap");
+
+    g_return_if_fail (c);
+    g_return_if_fail (title_pm);
+    g_return_if_fail (top_pm);
+
+    screen_info = c->screen_info;
+    width = frameWidth (c);
+    height = frameTop (c);
+
+    for (list = screen_info->title_cache; list; list = g_list_next (list))
+    {
+        entry = (TitleCacheEntry *) list->data;
+        if ((entry->state == state) && (entry->width == width) && (entry->height == height)
+            && (entry->left == left) && (entry->right == right)
+            && (g_strcmp0 (entry->name, c->name) == 0))
+        {
+            /* Most recently used first */
+            screen_info->title_cache = g_list_remove_link (screen_info->title_cache, list);
+            screen_info->title_cache = g_list_concat (list, screen_info->title_cache);
+            screen_info->title_cache_hits++;
+
+            *title_pm = entry->pm_title;
+            *top_pm = entry->pm_top;
+            return;
+        }
+    }
+
+    screen_info->title_cache_misses++;
+    frameCreateTitlePixmap (c, state, left, right, title_pm, top_pm);
+    if (xfwmPixmapNone (title_pm))
+    {
+        return;
+    }
+
+    entry = g_new0 (TitleCacheEntry, 1);
+    entry->name = g_strdup (c->name);
+    entry->state = state;
+    entry->width = width;
+    entry->height = height;
+    entry->left = left;
+    entry->right = right;
+    entry->pm_title = *title_pm;
+    entry->pm_top = *top_pm;
+    screen_info->title_cache = g_list_prepend (screen_info->title_cache, entry);
+
+    if (g_list_length (screen_info->title_cache) > TITLE_CACHE_SIZE)
+    {
+        list = g_list_last (screen_info->title_cache);
+        screen_info->title_cache = g_list_remove_link (screen_info->title_cache, list);
+        frameFreeTitleCacheEntry ((TitleCacheEntry *) list->data);
+        g_list_free_1 (list);
+    }
+
+    if (((screen_info->title_cache_hits + screen_info->title_cache_misses) % 100) == 0)
+    {
+        DBG ("title cache: %u hits, %u misses", screen_info->title_cache_hits,
+             screen_info->title_cache_misses);
+    }
+}
+
 static int
 getButtonFromLetter (char chr, Client * c)
 {
@@ -588,6 +699,50 @@ getLetterFromButton (int i, Client * c)
     return chr;
 }
 
+static void
+frameGetShapeKey (Client * c, int state, FramePixmap * frame_pix, int button_x[BUTTON_COUNT],
+                  FrameShapeKey * key)
+{
+    xfwmPixmap *my_pixmap;
+    int i;
+
+    /* Cleared first so that keys can be compared with memcmp () */
+    memset (key, 0, sizeof (FrameShapeKey));
+    key->valid = TRUE;
+    key->width = frameWidth (c);
+    key->height = frameHeight (c);
+    key->flags = FLAG_TEST (c->flags, CLIENT_FLAG_SHADED | CLIENT_FLAG_HAS_SHAPE |
+                                      CLIENT_FLAG_MAXIMIZED | CLIENT_FLAG_FULLSCREEN);
+
+    if (frame_pix)
+    {
+        key->state = state;
+        key->title_mask = frame_pix->pm_title.mask;
+        key->top_mask = frame_pix->pm_sides[SIDE_TOP].mask;
+        for (i = 0; i < BUTTON_COUNT; i++)
+        {
+            if (xfwmWindowVisible (&c->buttons[i]))
+            {
+                my_pixmap = clientGetButtonPixmap (c, i, clientGetButtonState (c, i, state));
+                key->button_mask[i] = my_pixmap->mask;
+                key->button_x[i] = button_x[i];
+            }
+        }
+    }
+    else
+    {
+        key->state = -1;
+    }
+}
+
+void
+frameClearShapeCache (Client * c)
+{
+    g_return_if_fail (c);
+
+    c->shape_key.valid = FALSE;
+}
+
 static void
 frameSetShape (Client * c, int state, FramePixmap * frame_pix, int button_x[BUTTON_COUNT])
 {
@@ -595,6 +750,7 @@ frameSetShape (Client * c, int state, FramePixmap * frame_pix, int button_x[BUTT
     DisplayInfo *display_info;
     XRectangle rect;
     xfwmPixmap *my_pixmap;
+    FrameShapeKey key;
     int i;
 
     TRACE ("entering frameSetShape");
@@ -608,6 +764,17 @@ frameSetShape (Client * c, int state, FramePixmap * frame_pix, int button_x[BUTT
         return;
     }
 
+    /* Nothing that the shape depends on has changed, keep the current one */
+    frameGetShapeKey (c, state, frame_pix, button_x, &key);
+    if (memcmp (&key, &c->shape_key, sizeof (FrameShapeKey)) == 0)
+    {
+        screen_info->shapes_reused++;
+        TRACE ("shape of client (0x%lx) unchanged, %u reused so far",
+               c->window, screen_info->shapes_reused);
+        return;
+    }
+    memcpy (&c->shape_key, &key, sizeof (FrameShapeKey));
+
     if (screen_info->shape_win == None)
     {
         screen_info->shape_win = XCreateSimpleWindow (display_info->dpy, screen_info->xroot, 0, 0, frameWidth (c), frameHeight (c), 0, 0, 0);
@@ -638,7 +805,31 @@ frameSetShape (Client * c, int state, FramePixmap * frame_pix, int button_x[BUTT
         XShapeCombineShape (display_info->dpy, screen_info->shape_win, ShapeBounding, frameLeft (c),
                             frameTop (c), c->window, ShapeBounding, ShapeSet);
     }
-    if (frame_pix)
+    if ((frame_pix) && FLAG_TEST (c->xfwm_flags, XFWM_FLAG_SINGLE_FRAME))
+    {
+        if (xfwmWindowVisible (&c->decoration))
+        {
+            /* The pixmap is left undefined under the client, shape it out */
+            XShapeCombineMask (display_info->dpy, MYWINDOW_XWINDOW (c->decoration), ShapeBounding,
+                               0, 0, c->decoration_pm.mask, ShapeSet);
+            XShapeCombineMask (display_info->dpy, screen_info->shape_win, ShapeBounding,
+                               0, 0, c->decoration_pm.mask, ShapeUnion);
+        }
+
+        for (i = 0; i < BUTTON_COUNT; i++)
+        {
+            if (xfwmWindowVisible (&c->buttons[i]))
+            {
+                my_pixmap = clientGetButtonPixmap (c, i, clientGetButtonState (c, i, state));
+                XShapeCombineMask (display_info->dpy, MYWINDOW_XWINDOW (c->buttons[i]),
+                                   ShapeBounding, 0, 0, my_pixmap->mask, ShapeSet);
+                XShapeCombineShape (display_info->dpy, screen_info->shape_win, ShapeBounding, button_x[i],
+                                    (frameTop (c) - screen_info->buttons[i][state].height + 1) / 2,
+                                    MYWINDOW_XWINDOW (c->buttons[i]), ShapeBounding, ShapeUnion);
+            }
+        }
+    }
+    else if (frame_pix)
     {
         XShapeCombineMask (display_info->dpy, MYWINDOW_XWINDOW (c->title), ShapeBounding,
                            0, 0, frame_pix->pm_title.mask, ShapeSet);
@@ -869,6 +1060,105 @@ frameSetShapeInput (Client * c)
     XShapeCombineShape(display_info->dpy, c->frame, ShapeInput, 0, 0, screen_info->shape_win, ShapeInput, ShapeSet);
 }
 
+static void
+frameDrawPiece (xfwmPixmap * src, xfwmPixmap * dst, int x, int y, int w, int h)
+{
+    if (!xfwmPixmapNone (src))
+    {
+        xfwmPixmapFill (src, dst, x, y, w, h);
+    }
+}
+
+/*
+ * Paint the title, sides and corners already rendered in frame_pix onto the
+ * single decoration window, in the stacking order of the separate windows.
+ */
+static void
+frameDrawDecoration (Client * c, int state, FramePixmap * frame_pix)
+{
+    ScreenInfo *screen_info;
+    Display *dpy;
+    xfwmPixmap *pm;
+    XGCValues gv;
+    GC gc;
+    int width, height;
+
+    TRACE ("entering frameDrawDecoration");
+
+    screen_info = c->screen_info;
+    dpy = myScreenGetXDisplay (screen_info);
+    width = frameWidth (c);
+    height = frameHeight (c);
+    pm = &c->decoration_pm;
+
+    /*
+     * Keep the pixmap from one redraw to the next, so that an interactive
+     * resize only allocates a new one every DECORATION_PIXMAP_STEP pixels.
+     */
+    if ((pm->width < width) || (pm->height < height) ||
+        (pm->width > DECORATION_PIXMAP_SIZE (width) + DECORATION_PIXMAP_STEP) ||
+        (pm->height > DECORATION_PIXMAP_SIZE (height) + DECORATION_PIXMAP_STEP))
+    {
+        xfwmPixmapFree (pm);
+        xfwmPixmapCreate (screen_info, pm, DECORATION_PIXMAP_SIZE (width),
+                          DECORATION_PIXMAP_SIZE (height));
+    }
+    if (xfwmPixmapNone (pm))
+    {
+        xfwmWindowHide (&c->decoration);
+        return;
+    }
+
+    /* Only what the pieces cover is part of the decoration */
+    gv.foreground = 0;
+    gc = XCreateGC (dpy, pm->mask, GCForeground, &gv);
+    XFillRectangle (dpy, pm->mask, gc, 0, 0, pm->width, pm->height);
+    XFreeGC (dpy, gc);
+
+    frameDrawPiece (&frame_pix->pm_sides[SIDE_LEFT], pm, 0, frameTop (c),
+                    frame_pix->pm_sides[SIDE_LEFT].width, frame_pix->pm_sides[SIDE_LEFT].height);
+    frameDrawPiece (&frame_pix->pm_sides[SIDE_RIGHT], pm, width - frameRight (c), frameTop (c),
+                    frame_pix->pm_sides[SIDE_RIGHT].width, frame_pix->pm_sides[SIDE_RIGHT].height);
+    frameDrawPiece (&frame_pix->pm_sides[SIDE_BOTTOM], pm,
+                    screen_info->corners[CORNER_BOTTOM_LEFT][state].width, height - frameBottom (c),
+                    frame_pix->pm_sides[SIDE_BOTTOM].width, frame_pix->pm_sides[SIDE_BOTTOM].height);
+
+    if (!FLAG_TEST_ALL (c->flags, CLIENT_FLAG_MAXIMIZED)
+        || !(screen_info->params->borderless_maximize))
+    {
+        frameDrawPiece (&screen_info->corners[CORNER_TOP_LEFT][state], pm, 0, 0,
+                        frameTopLeftWidth (c, state),
+                        screen_info->corners[CORNER_TOP_LEFT][state].height);
+        frameDrawPiece (&screen_info->corners[CORNER_TOP_RIGHT][state], pm,
+                        width - frameTopRightWidth (c, state), 0,
+                        frameTopRightWidth (c, state),
+                        screen_info->corners[CORNER_TOP_RIGHT][state].height);
+        frameDrawPiece (&screen_info->corners[CORNER_BOTTOM_LEFT][state], pm,
+                        0, height - screen_info->corners[CORNER_BOTTOM_LEFT][state].height,
+                        screen_info->corners[CORNER_BOTTOM_LEFT][state].width,
+                        screen_info->corners[CORNER_BOTTOM_LEFT][state].height);
+        frameDrawPiece (&screen_info->corners[CORNER_BOTTOM_RIGHT][state], pm,
+                        width - screen_info->corners[CORNER_BOTTOM_RIGHT][state].width,
+                        height - screen_info->corners[CORNER_BOTTOM_RIGHT][state].height,
+                        screen_info->corners[CORNER_BOTTOM_RIGHT][state].width,
+                        screen_info->corners[CORNER_BOTTOM_RIGHT][state].height);
+    }
+
+    frameDrawPiece (&frame_pix->pm_title, pm, frameTopLeftWidth (c, state), 0,
+                    frame_pix->pm_title.width, frame_pix->pm_title.height);
+
+    if (!FLAG_TEST_ALL (c->flags, CLIENT_FLAG_MAXIMIZED)
+        || !(screen_info->params->borderless_maximize))
+    {
+        frameDrawPiece (&frame_pix->pm_sides[SIDE_TOP], pm,
+                        screen_info->corners[CORNER_TOP_LEFT][state].width, 0,
+                        frame_pix->pm_sides[SIDE_TOP].width, frame_pix->pm_sides[SIDE_TOP].height);
+    }
+
+    xfwmWindowSetBG (&c->decoration, pm);
+    xfwmWindowShow (&c->decoration, 0, 0, width, height, TRUE);
+}
+
 static void
 frameDrawWin (Client * c)
 {
@@ -936,6 +1226,7 @@ frameDrawWin (Client * c)
     if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_NEEDS_REDRAW))
     {
         FLAG_UNSET (c->xfwm_flags, XFWM_FLAG_NEEDS_REDRAW);
+        frameClearShapeCache (c);
         width_changed = TRUE;
         height_changed = TRUE;
         requires_clearing = TRUE;
@@ -1058,7 +1349,7 @@ frameDrawWin (Client * c)
         xfwmPixmapInit (screen_info, &frame_pix.pm_sides[SIDE_RIGHT]);
 
         /* The title is always visible */
-        frameCreateTitlePixmap (c, state, left, right, &frame_pix.pm_title, &frame_pix.pm_sides[SIDE_TOP]);
+        frameGetTitlePixmap (c, state, left, right, &frame_pix.pm_title, &frame_pix.pm_sides[SIDE_TOP]);
         xfwmWindowSetBG (&c->title, &frame_pix.pm_title);
         xfwmWindowShow (&c->title,
             frameTopLeftWidth (c, state), 0, top_width,
@@ -1172,10 +1463,13 @@ frameDrawWin (Client * c)
                 screen_info->corners[CORNER_BOTTOM_RIGHT][state].height,
                 requires_clearing);
         }
+        if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_SINGLE_FRAME))
+        {
+            frameDrawDecoration (c, state, &frame_pix);
+        }
         frameSetShape (c, state, &frame_pix, button_x);
 
-        xfwmPixmapFree (&frame_pix.pm_title);
-        xfwmPixmapFree (&frame_pix.pm_sides[SIDE_TOP]);
+        /* The title and top side pixmaps are kept in the title cache */
         xfwmPixmapFree (&frame_pix.pm_sides[SIDE_BOTTOM]);
         xfwmPixmapFree (&frame_pix.pm_sides[SIDE_LEFT]);
         xfwmPixmapFree (&frame_pix.pm_sides[SIDE_RIGHT]);
@@ -1186,6 +1480,10 @@ frameDrawWin (Client * c)
         {
             xfwmWindowHide (&c->title);
         }
+        if (xfwmWindowVisible (&c->decoration))
+        {
+            xfwmWindowHide (&c->decoration);
+        }
         for (i = 0; i < 4; i++)
         {
             if (MYWINDOW_XWINDOW (c->sides[i]) && xfwmWindowVisible (&c->sides[i]))
@@ -1214,15 +1512,47 @@ frameDrawWin (Client * c)
 static gboolean
 update_frame_idle_cb (gpointer data)
 {
+    ScreenInfo *screen_info;
+    GList *queue, *list;
     Client *c;
+    guint drawn;
 
     TRACE ("entering update_frame_idle_cb");
 
-    c = (Client *) data;
-    g_return_val_if_fail (c, FALSE);
+    screen_info = (ScreenInfo *) data;
+    g_return_val_if_fail (screen_info, FALSE);
 
-    frameDrawWin (c);
-    c->frame_timeout_id = 0;
+    screen_info->frame_redraw_id = 0;
+    queue = g_list_reverse (screen_info->frame_redraw_queue);
+    screen_info->frame_redraw_queue = NULL;
+
+    /* The focused window first, then in the order they were queued */
+    c = clientGetFocus ();
+    list = (c) ? g_list_find (queue, c) : NULL;
+    if (list)
+    {
+        queue = g_list_remove_link (queue, list);
+        queue = g_list_concat (list, queue);
+    }
+
+    drawn = 0;
+    for (list = queue; list; list = g_list_next (list))
+    {
+        c = (Client *) list->data;
+        FLAG_UNSET (c->xfwm_flags, XFWM_FLAG_REDRAW_QUEUED);
+        if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_VISIBLE))
+        {
+            frameDrawWin (c);
+            drawn++;
+        }
+        else
+        {
+            /* Hidden since it was queued, wait until it's shown again */
+            FLAG_SET (c->xfwm_flags, XFWM_FLAG_REDRAW_DEFERRED);
+        }
+    }
+    TRACE ("redrew %u frames out of %u queued", drawn, g_list_length (queue));
+    g_list_free (queue);
 
     return FALSE;
 }
@@ -1230,14 +1560,23 @@ update_frame_idle_cb (gpointer data)
 void
 frameClearQueueDraw (Client * c)
 {
+    ScreenInfo *screen_info;
+
     g_return_if_fail (c);
 
     TRACE ("entering frameClearQueueDraw for \"%s\" (0x%lx)", c->name, c->window);
 
-    if (c->frame_timeout_id)
+    screen_info = c->screen_info;
+    FLAG_UNSET (c->xfwm_flags, XFWM_FLAG_REDRAW_DEFERRED);
+    if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_REDRAW_QUEUED))
     {
-        g_source_remove (c->frame_timeout_id);
-        c->frame_timeout_id = 0;
+        FLAG_UNSET (c->xfwm_flags, XFWM_FLAG_REDRAW_QUEUED);
+        screen_info->frame_redraw_queue = g_list_remove (screen_info->frame_redraw_queue, c);
+        if ((screen_info->frame_redraw_queue == NULL) && (screen_info->frame_redraw_id))
+        {
+            g_source_remove (screen_info->frame_redraw_id);
+            screen_info->frame_redraw_id = 0;
+        }
     }
 }
 
@@ -1258,24 +1597,143 @@ frameDraw (Client * c, gboolean clear_all)
 void
 frameQueueDraw (Client * c, gboolean clear_all)
 {
+    ScreenInfo *screen_info;
+
     g_return_if_fail (c);
 
     TRACE ("entering frameQueueDraw for \"%s\" (0x%lx)", c->name, c->window);
 
-    /* Reschedule update */
-    if (c->frame_timeout_id)
-    {
-        frameClearQueueDraw (c);
-    }
+    screen_info = c->screen_info;
     if (clear_all)
     {
         FLAG_SET (c->xfwm_flags, XFWM_FLAG_NEEDS_REDRAW);
     }
-    /* Otherwise leave previous schedule */
-    if (c->frame_timeout_id == 0)
+
+    /* Nobody can see it, redraw when the window gets shown */
+    if (!FLAG_TEST (c->xfwm_flags, XFWM_FLAG_VISIBLE))
     {
-        c->frame_timeout_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
-                                              update_frame_idle_cb, c, NULL);
+        FLAG_SET (c->xfwm_flags, XFWM_FLAG_REDRAW_DEFERRED);
+        return;
+    }
+
+    /* Already queued, leave previous schedule */
+    if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_REDRAW_QUEUED))
+    {
+        return;
+    }
+
+    /* All frames queued on the screen get redrawn together */
+    FLAG_SET (c->xfwm_flags, XFWM_FLAG_REDRAW_QUEUED);
+    screen_info->frame_redraw_queue = g_list_prepend (screen_info->frame_redraw_queue, c);
+    if (screen_info->frame_redraw_id == 0)
+    {
+        screen_info->frame_redraw_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                                        update_frame_idle_cb, screen_info, NULL);
     }
 }
 
+void
+frameFlushTitleCache (ScreenInfo *screen_info)
+{
+    GList *list;
+
+    g_return_if_fail (screen_info);
+
+    TRACE ("entering frameFlushTitleCache");
+
+    for (list = screen_info->title_cache; list; list = g_list_next (list))
+    {
+        frameFreeTitleCacheEntry ((TitleCacheEntry *) list->data);
+    }
+    g_list_free (screen_info->title_cache);
+    screen_info->title_cache = NULL;
+}
+
+/*
+ * Find which part of the decoration is at the given position, relative to
+ * the frame: one of the corners, CORNER_COUNT + one of the sides,
+ * FRAME_PART_TITLE or FRAME_PART_NONE. This mirrors the layout of the
+ * separate decoration windows, for frames drawn on a single window.
+ */
+int
+frameGetPartAt (Client * c, int x, int y)
+{
+    ScreenInfo *screen_info;
+    int state, width, height, top_height;
+
+    g_return_val_if_fail (c != NULL, FRAME_PART_NONE);
+
+    if (!FLAG_TEST (c->xfwm_flags, XFWM_FLAG_HAS_BORDER)
+        || FLAG_TEST (c->flags, CLIENT_FLAG_FULLSCREEN))
+    {
+        return FRAME_PART_NONE;
+    }
+
+    screen_info = c->screen_info;
+    state = FLAG_TEST (c->xfwm_flags, XFWM_FLAG_DRAW_ACTIVE) ? ACTIVE : INACTIVE;
+    width = frameWidth (c);
+    height = frameHeight (c);
+
+    if ((x < 0) || (y < 0) || (x >= width) || (y >= height))
+    {
+        return FRAME_PART_NONE;
+    }
+
+    if (FLAG_TEST_ALL (c->flags, CLIENT_FLAG_MAXIMIZED)
+        && (screen_info->params->borderless_maximize))
+    {
+        return ((y < frameTop (c)) ? FRAME_PART_TITLE : FRAME_PART_NONE);
+    }
+
+    if ((x < frameTopLeftWidth (c, state))
+        && (y < screen_info->corners[CORNER_TOP_LEFT][state].height))
+    {
+        return CORNER_TOP_LEFT;
+    }
+    if ((x >= width - frameTopRightWidth (c, state))
+        && (y < screen_info->corners[CORNER_TOP_RIGHT][state].height))
+    {
+        return CORNER_TOP_RIGHT;
+    }
+    if ((x < screen_info->corners[CORNER_BOTTOM_LEFT][state].width)
+        && (y >= height - screen_info->corners[CORNER_BOTTOM_LEFT][state].height))
+    {
+        return CORNER_BOTTOM_LEFT;
+    }
+    if ((x >= width - screen_info->corners[CORNER_BOTTOM_RIGHT][state].width)
+        && (y >= height - screen_info->corners[CORNER_BOTTOM_RIGHT][state].height))
+    {
+        return CORNER_BOTTOM_RIGHT;
+    }
+
+    if (y < frameTop (c))
+    {
+        /* Same height as the top side drawn by frameCreateTitlePixmap () */
+        if (!xfwmPixmapNone (&screen_info->top[3][ACTIVE]))
+        {
+            top_height = screen_info->top[3][ACTIVE].height;
+        }
+        else
+        {
+            top_height = frameTop (c) / 10 + 1;
+        }
+        return ((y < top_height) ? CORNER_COUNT + SIDE_TOP : FRAME_PART_TITLE);
+    }
+    if (y >= height - frameBottom (c))
+    {
+        return CORNER_COUNT + SIDE_BOTTOM;
+    }
+    if (!FLAG_TEST (c->flags, CLIENT_FLAG_SHADED))
+    {
+        if (x < frameLeft (c))
+        {
+            return CORNER_COUNT + SIDE_LEFT;
+        }
+        if (x >= width - frameRight (c))
+        {
+            return CORNER_COUNT + SIDE_RIGHT;
+        }
+    }
+
+    return FRAME_PART_NONE;
+}
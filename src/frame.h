@@ -32,6 +32,10 @@
 #include "mypixmap.h"
 #include "client.h"
 
+/* Parts of the decoration besides corners and sides, see frameGetPartAt () */
+#define FRAME_PART_NONE         -1
+#define FRAME_PART_TITLE        (CORNER_COUNT + SIDE_COUNT)
+
 int                      frameDecorationLeft                    (ScreenInfo *);
 int                      frameDecorationRight                   (ScreenInfo *);
 int                      frameDecorationTop                     (ScreenInfo *);
@@ -50,5 +54,10 @@ void                     frameQueueDraw                         (Client *,
                                                                  gboolean);
 void                     frameDraw                              (Client *,
                                                                  gboolean);
+void                     frameFlushTitleCache                   (ScreenInfo *);
+void                     frameClearShapeCache                   (Client *);
+int                      frameGetPartAt                         (Client *,
+                                                                 int,
+                                                                 int);
 
 #endif /* INC_FRAME_H */
@@ -421,6 +421,7 @@ setNetSupportedHint (DisplayInfo *display_info, Window root, Window check_win)
     atoms[i++] = display_info->atoms[NET_WM_ACTION_SHADE];
     atoms[i++] = display_info->atoms[NET_WM_ACTION_STICK];
     atoms[i++] = display_info->atoms[NET_WM_ALLOWED_ACTIONS];
+    atoms[i++] = display_info->atoms[NET_WM_BYPASS_COMPOSITOR];
     atoms[i++] = display_info->atoms[NET_WM_CONTEXT_HELP];
     atoms[i++] = display_info->atoms[NET_WM_DESKTOP];
     atoms[i++] = display_info->atoms[NET_WM_FULLSCREEN_MONITORS];
@@ -1170,6 +1171,25 @@ getOpacityLock (DisplayInfo *display_info, Window window)
     return !!getHint (display_info, window, NET_WM_WINDOW_OPACITY_LOCKED, &val);
 }
 
+gboolean
+getBypassCompositor (DisplayInfo *display_info, Window window, gint *bypass)
+{
+    long val;
+
+    g_return_val_if_fail (window != None, FALSE);
+    g_return_val_if_fail (bypass != NULL, FALSE);
+    TRACE ("entering getBypassCompositor");
+
+    val = 0;
+    if (getHint (display_info, window, NET_WM_BYPASS_COMPOSITOR, &val))
+    {
+        *bypass = (gint) val;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 gboolean
 setXAtomManagerOwner (DisplayInfo *display_info, Atom atom, Window root, Window w)
 {
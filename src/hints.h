@@ -274,6 +274,9 @@ gboolean                 getOpacity                             (DisplayInfo *,
                                                                  guint *);
 gboolean                 getOpacityLock                         (DisplayInfo *,
                                                                  Window);
+gboolean                 getBypassCompositor                    (DisplayInfo *,
+                                                                 Window,
+                                                                 gint *);
 gboolean                 setXAtomManagerOwner                   (DisplayInfo *,
                                                                  Atom,
                                                                  Window,
@@ -44,7 +44,10 @@
 #include "poswin.h"
 #include "screen.h"
 #include "settings.h"
+#include "spatial.h"
+#include "tiling.h"
 #include "transients.h"
+#include "wireframe.h"
 #include "event_filter.h"
 #include "workspaces.h"
 #include "xsync.h"
@@ -73,6 +76,10 @@ struct _MoveResizeData
     gint ow, oh;
     gint oldw, oldh;
     gint handle;
+    gint tile_zone;
+    gint tile_x, tile_y;
+    GdkRectangle tile_rect;
+    Window tile_preview;
     Poswin *poswin;
 };
 
@@ -348,15 +355,19 @@ clientFindClosestEdgeX (Client *c, int edge_pos)
 
     Client *c2;
     ScreenInfo *screen_info;
-    guint i;
+    GList *candidates, *list;
     int snap_width, closest;
 
     screen_info = c->screen_info;
     snap_width = screen_info->params->snap_width;
     closest = edge_pos + snap_width + 2; /* This only needs to be out of the snap range to work. -Cliff */
 
-    for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
+    /* Only the windows having an edge within the snapping range matter */
+    candidates = spatialQuery (screen_info, edge_pos - snap_width - 2, 0,
+                               edge_pos + snap_width + 2, screen_info->height);
+    for (list = candidates; list; list = g_list_next (list))
     {
+        c2 = (Client *) list->data;
         if (FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE)  && (c2 != c) &&
             (((screen_info->params->snap_to_windows) && (c2->win_layer == c->win_layer))
              || ((screen_info->params->snap_to_border)
@@ -378,6 +389,8 @@ clientFindClosestEdgeX (Client *c, int edge_pos)
         }
     }
 
+    g_list_free (candidates);
+
     if (abs (closest - edge_pos) > snap_width)
     {
         closest = edge_pos;
@@ -395,15 +408,19 @@ clientFindClosestEdgeY (Client *c, int edge_pos)
 
     Client *c2;
     ScreenInfo *screen_info;
-    guint i;
+    GList *candidates, *list;
     int snap_width, closest;
 
     screen_info = c->screen_info;
     snap_width = screen_info->params->snap_width;
     closest = edge_pos + snap_width + 1; /* This only needs to be out of the snap range to work. -Cliff */
 
-    for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
+    /* Only the windows having an edge within the snapping range matter */
+    candidates = spatialQuery (screen_info, 0, edge_pos - snap_width - 2,
+                               screen_info->width, edge_pos + snap_width + 2);
+    for (list = candidates; list; list = g_list_next (list))
     {
+        c2 = (Client *) list->data;
         if (FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE)  && (c2 != c) &&
             (((screen_info->params->snap_to_windows) && (c2->win_layer == c->win_layer))
              || ((screen_info->params->snap_to_border)
@@ -425,6 +442,8 @@ clientFindClosestEdgeY (Client *c, int edge_pos)
         }
     }
 
+    g_list_free (candidates);
+
     if (abs (closest - edge_pos) > snap_width)
     {
         closest = edge_pos;
@@ -438,7 +457,7 @@ clientSnapPosition (Client * c, int prev_x, int prev_y)
 {
     ScreenInfo *screen_info;
     Client *c2;
-    guint i;
+    GList *candidates, *list;
     int cx, cy, delta;
     int disp_x, disp_y, disp_max_x, disp_max_y;
     int frame_x, frame_y, frame_height, frame_width;
@@ -516,8 +535,15 @@ clientSnapPosition (Client * c, int prev_x, int prev_y)
         }
     }
 
-    for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
+    /* Only the windows within the snapping range matter */
+    candidates = spatialQuery (screen_info,
+                               frame_x - screen_info->params->snap_width - 1,
+                               frame_y - screen_info->params->snap_width - 1,
+                               frame_x2 + screen_info->params->snap_width + 1,
+                               frame_y2 + screen_info->params->snap_width + 1);
+    for (list = candidates; list; list = g_list_next (list))
     {
+        c2 = (Client *) list->data;
         if (FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE)  && (c2 != c) &&
             (((screen_info->params->snap_to_windows) && (c2->win_layer == c->win_layer))
              || ((screen_info->params->snap_to_border)
@@ -577,6 +603,8 @@ clientSnapPosition (Client * c, int prev_x, int prev_y)
         }
     }
 
+    g_list_free (candidates);
+
     if (best_delta_x <= screen_info->params->snap_width)
     {
         c->x = best_frame_x + frame_left;
@@ -587,6 +615,42 @@ clientSnapPosition (Client * c, int prev_x, int prev_y)
     }
 }
 
+static void
+clientUpdateTilePreview (MoveResizeData *passdata)
+{
+    ScreenInfo *screen_info;
+    GdkRectangle rect;
+
+    screen_info = passdata->c->screen_info;
+    if (!tilingGetZoneArea (screen_info, passdata->tile_x, passdata->tile_y,
+                            passdata->tile_zone, &rect))
+    {
+        rect.x = rect.y = rect.width = rect.height = 0;
+    }
+
+    /* Only touch the preview when the target actually changes */
+    if ((rect.x == passdata->tile_rect.x) && (rect.y == passdata->tile_rect.y) &&
+        (rect.width == passdata->tile_rect.width) && (rect.height == passdata->tile_rect.height))
+    {
+        return;
+    }
+    passdata->tile_rect = rect;
+
+    if ((rect.width == 0) || (rect.height == 0))
+    {
+        if (passdata->tile_preview != None)
+        {
+            wireframePreviewUpdate (screen_info, passdata->tile_preview, NULL);
+        }
+        return;
+    }
+    if (passdata->tile_preview == None)
+    {
+        passdata->tile_preview = wireframePreviewCreate (screen_info);
+    }
+    wireframePreviewUpdate (screen_info, passdata->tile_preview, &rect);
+}
+
 static eventFilterStatus
 clientButtonReleaseFilter (XEvent * xevent, gpointer data)
 {
@@ -677,6 +741,8 @@ clientMoveEventFilter (XEvent * xevent, gpointer data)
 
             c->x = passdata->cancel_x;
             c->y = passdata->cancel_y;
+            passdata->tile_zone = TILE_NO_ZONE;
+            clientUpdateTilePreview (passdata);
 
             if (screen_info->params->box_move)
             {
@@ -727,57 +793,6 @@ clientMoveEventFilter (XEvent * xevent, gpointer data)
         {
             clientDrawOutline (c);
         }
-        if(1/*dotile*/)
-	{
-	  int msx, msy, maxx, maxy;
-          int rx, ry;
-          msx = xevent->xmotion.x_root;
-          msy = xevent->xmotion.y_root;
-          maxx = screen_info->width - 1;
-          maxy = screen_info->height - 1; 
-	  
-	  //left
-	  if((msx <= 50 && msx >0))
-	  {
-	      int mspx=0;
-	      int mspy=0;
-	      int mspw=maxx;
-	      int msph=maxy;
-	      clientMaxSpace(screen_info,&mspx,&mspy,&mspw,&msph);
-	      configure_flags = CFG_FORCE_REDRAW;
-	      passdata->move_resized = 1;
-	      wc.width = mspw/2+frameLeft(c)+frameRight(c);
-	      wc.height = msph-frameTop(c);
-	      //wc.x = 0;
-	      //wc.y = 0;
-	      c->x = mspx+frameLeft(c);
-	      c->y = mspy+frameTop(c);
-	      
-	      int changes = CWX | CWY | CWWidth | CWHeight;
-	      clientConfigure (c, &wc, changes, configure_flags);
-	      return;
-	  }
-	  if(((msx > maxx-50) && msx < maxx))
-	  {
-	      int mspx=maxx/2;
-	      int mspy=0;
-	      int mspw=maxx;
-	      int msph=maxy;
-	      clientMaxSpace(screen_info,&mspx,&mspy,&mspw,&msph);
-	      configure_flags = CFG_FORCE_REDRAW;
-	      passdata->move_resized = 1;
-	      wc.width = mspw/2+frameLeft(c)+frameRight(c);
-	      wc.height = msph-frameTop(c);
-	      //wc.x = 0;
-	      //wc.y = 0;
-	      c->x = mspx + frameLeft(c)*2+frameRight(c)*2;
-	      c->y = mspy+frameTop(c);
-	      
-	      int changes = CWX | CWY | CWWidth | CWHeight;
-	      clientConfigure (c, &wc, changes, configure_flags);
-	      return;
-	  }
-	}
         if ((screen_info->workspace_count > 1) && !(passdata->is_transient))
         {
             if ((screen_info->params->wrap_windows) && (screen_info->params->wrap_resistance))
@@ -792,7 +807,6 @@ clientMoveEventFilter (XEvent * xevent, gpointer data)
                 rx = 0;
                 ry = 0;
                 warp_pointer = FALSE;
-		
 
                 if ((msx == 0) || (msx == maxx))
                 {
@@ -948,6 +962,17 @@ clientMoveEventFilter (XEvent * xevent, gpointer data)
             clientConstrainPos(c, FALSE);
         }
 
+        /* Tiling only happens on release, until then just preview the zone */
+        passdata->tile_x = xevent->xmotion.x_root;
+        passdata->tile_y = xevent->xmotion.y_root;
+        passdata->tile_zone = tilingGetZone (screen_info, passdata->tile_x, passdata->tile_y);
+        /* Only maximizing applies to windows that cannot be tiled */
+        if ((passdata->tile_zone != TILE_ZONE_MAXIMIZE) && !tilingIsTileable (c))
+        {
+            passdata->tile_zone = TILE_NO_ZONE;
+        }
+        clientUpdateTilePreview (passdata);
+
 #ifdef SHOW_POSITION
         if (passdata->poswin)
         {
@@ -1050,6 +1075,10 @@ clientMove (Client * c, XEvent * ev)
     passdata.button = 0;
     passdata.is_transient = clientIsValidTransientOrModal (c);
     passdata.move_resized = FALSE;
+    passdata.tile_zone = TILE_NO_ZONE;
+    passdata.tile_rect.x = passdata.tile_rect.y = 0;
+    passdata.tile_rect.width = passdata.tile_rect.height = 0;
+    passdata.tile_preview = None;
 
     if (ev && (ev->type == ButtonPress))
     {
@@ -1123,15 +1152,27 @@ clientMove (Client * c, XEvent * ev)
     /* Set window opacity to its original value */
     clientSetOpacity (c, c->opacity, OPACITY_MOVE, 0);
 
-    wc.x = c->x;
-    wc.y = c->y;
-    if (passdata.move_resized)
+    if (passdata.tile_preview != None)
     {
-        wc.width = c->width;
-        wc.height = c->height;
-        changes |= CWWidth | CWHeight;
+        wireframeDelete (screen_info, passdata.tile_preview);
+    }
+
+    /*
+     * When snapping, the window is configured once by the tiling code,
+     * it was already moved along the way unless using box move.
+     */
+    if ((passdata.tile_zone == TILE_NO_ZONE) || (screen_info->params->box_move))
+    {
+        wc.x = c->x;
+        wc.y = c->y;
+        if (passdata.move_resized)
+        {
+            wc.width = c->width;
+            wc.height = c->height;
+            changes |= CWWidth | CWHeight;
+        }
+        clientConfigure (c, &wc, changes, NO_CFG_FLAG);
     }
-    clientConfigure (c, &wc, changes, NO_CFG_FLAG);
 
     if (!passdata.released)
     {
@@ -1150,8 +1191,16 @@ clientMove (Client * c, XEvent * ev)
     {
         myDisplayUngrabServer (display_info);
     }
-    //clientSetWidth(c,100,1);
-    //clientSetHeight(c,100,1);
+
+    if (passdata.tile_zone != TILE_NO_ZONE)
+    {
+        tilingSnapClient (c, passdata.tile_x, passdata.tile_y, passdata.tile_zone);
+    }
+    else if ((c->tile_layout) && ((c->x != passdata.cancel_x) || (c->y != passdata.cancel_y)))
+    {
+        /* Dragged out of its tile, the window floats again */
+        tilingUnmanageClient (c);
+    }
 }
 
 static gboolean
@@ -1374,6 +1423,10 @@ clientResizeEventFilter (XEvent * xevent, gpointer data)
             {
                 clientDrawOutline (c);
             }
+            else if (c->tile_layout)
+            {
+                tilingResizeClient (c);
+            }
             else
             {
                 clientResizeConfigure (c, prev_x, prev_y, prev_width, prev_height);
@@ -1517,6 +1570,11 @@ clientResizeEventFilter (XEvent * xevent, gpointer data)
         {
             clientDrawOutline (c);
         }
+        else if (c->tile_layout)
+        {
+            /* Move the edges shared with the neighbouring tiles as well */
+            tilingResizeClient (c);
+        }
         else
         {
             clientResizeConfigure (c, prev_x, prev_y, prev_width, prev_height);
@@ -1690,11 +1748,19 @@ clientResize (Client * c, int handle, XEvent * ev)
         clientRemoveMaximizeFlag (c);
     }
 
-    wc.x = c->x;
-    wc.y = c->y;
-    wc.width = c->width;
-    wc.height = c->height;
-    clientConfigure (c, &wc, CWX | CWY | CWHeight | CWWidth, NO_CFG_FLAG);
+    if (c->tile_layout)
+    {
+        tilingResizeClient (c);
+        tilingResizeDone (c);
+    }
+    else
+    {
+        wc.x = c->x;
+        wc.y = c->y;
+        wc.width = c->width;
+        wc.height = c->height;
+        clientConfigure (c, &wc, CWX | CWY | CWHeight | CWWidth, NO_CFG_FLAG);
+    }
 #ifdef HAVE_XSYNC
     clientXSyncClearTimeout (c);
     c->xsync_waiting = FALSE;
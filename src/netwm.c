@@ -43,6 +43,7 @@
 #include "misc.h"
 #include "netwm.h"
 #include "screen.h"
+#include "spatial.h"
 #include "stacking.h"
 #include "terminate.h"
 #include "transients.h"
@@ -1133,6 +1134,7 @@ clientGetNetStruts (Client * c)
     new_flags = c->flags & (CLIENT_FLAG_HAS_STRUT | CLIENT_FLAG_HAS_STRUT_PARTIAL);
     if (old_flags != new_flags)
     {
+        spatialUpdateClient (c);
         return TRUE;
     }
 
@@ -1584,6 +1586,7 @@ clientAddUserTimeWin (Client * c)
     {
         XSelectInput (display_info->dpy, c->user_time_win, PropertyChangeMask);
     }
+    myDisplayAddClientWindow (display_info, c->user_time_win, c, SEARCH_WIN_USER_TIME);
 }
 
 void
@@ -1602,4 +1605,5 @@ clientRemoveUserTimeWin (Client * c)
     {
         XSelectInput (display_info->dpy, c->user_time_win, NoEventMask);
     }
+    myDisplayRemoveClientWindow (display_info, c->user_time_win, c, SEARCH_WIN_USER_TIME);
 }
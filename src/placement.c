@@ -37,6 +37,18 @@
 #include "workspaces.h"
 #include "frame.h"
 #include "netwm.h"
+#include "spatial.h"
+
+#ifndef PLACEMENT_STEP
+#define PLACEMENT_STEP 8
+#endif
+
+typedef struct _PlacementInterval PlacementInterval;
+struct _PlacementInterval
+{
+    gint start;
+    gint end;
+};
 
 /* Compute rectangle overlap area */
 
@@ -99,7 +111,7 @@ void
 clientMaxSpace (ScreenInfo *screen_info, int *x, int *y, int *w, int *h)
 {
     Client *c2;
-    guint i;
+    GList *list;
     gint delta, screen_width, screen_height;
 
     g_return_if_fail (x != NULL);
@@ -111,8 +123,9 @@ clientMaxSpace (ScreenInfo *screen_info, int *x, int *y, int *w, int *h)
     screen_height = 0;
     delta = 0;
 
-    for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
+    for (list = spatialGetStruts (screen_info); list; list = g_list_next (list))
     {
+        c2 = (Client *) list->data;
         if (FLAG_TEST (c2->flags, CLIENT_FLAG_HAS_STRUT)
             && FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE))
         {
@@ -532,16 +545,84 @@ clientAutoMaximize (Client * c, int full_w, int full_h)
     }
 }
 
+static gint
+placementFloorDiv (gint a, gint b)
+{
+    if (a >= 0)
+    {
+        return a / b;
+    }
+    return -((-a + b - 1) / b);
+}
+
+static gint
+placementCompareInt (gconstpointer a, gconstpointer b)
+{
+    return *((const gint *) a) - *((const gint *) b);
+}
+
+static gint
+placementCompareInterval (gconstpointer a, gconstpointer b)
+{
+    return ((const PlacementInterval *) a)->start - ((const PlacementInterval *) b)->start;
+}
+
+/*
+   Add the grid steps around a breakpoint of the overlap function, the
+   grid being "count" steps of PLACEMENT_STEP pixels starting at "origin"
+ */
+static void
+placementAddSteps (GArray *steps, gint pos, gint origin, gint count)
+{
+    gint step;
+
+    step = placementFloorDiv (pos - origin, PLACEMENT_STEP);
+    step = CLAMP (step, 0, count - 1);
+    g_array_append_val (steps, step);
+    step = placementFloorDiv (pos - origin + PLACEMENT_STEP - 1, PLACEMENT_STEP);
+    step = CLAMP (step, 0, count - 1);
+    g_array_append_val (steps, step);
+}
+
+static void
+placementSortSteps (GArray *steps)
+{
+    guint i, j;
+
+    g_array_sort (steps, placementCompareInt);
+    for (i = 0, j = 0; i < steps->len; i++)
+    {
+        if ((j == 0) || (g_array_index (steps, gint, i) != g_array_index (steps, gint, j - 1)))
+        {
+            g_array_index (steps, gint, j++) = g_array_index (steps, gint, i);
+        }
+    }
+    g_array_set_size (steps, j);
+}
+
+/*
+   The placement looks for the position with the least overlap on a grid
+   of PLACEMENT_STEP pixels, top-left first. Along each axis, the overlap
+   with a window only changes slope where an edge of the new frame crosses
+   an edge of that window. Between such breakpoints the total overlap is
+   bilinear, so the first minimum always sits on a grid step next to a
+   breakpoint (or on the border of the area) and only those steps need to
+   be checked, instead of every step of the grid.
+ */
 static void
 smartPlacement (Client * c, int full_x, int full_y, int full_w, int full_h)
 {
     Client *c2;
     ScreenInfo *screen_info;
+    GList *candidates, *list;
+    GArray *rects, *row, *xs, *ys, *blocked;
+    GdkRectangle *r;
     gfloat best_overlaps;
-    guint i;
-    gint test_x, test_y, xmax, ymax, best_x, best_y;
+    guint i, j, k;
+    gint xmax, ymax, best_x, best_y, count_x, count_y, step;
     gint frame_height, frame_width, frame_left, frame_top;
-    gboolean first;
+    gint test_x, test_y;
+    gboolean first, found;
 
     g_return_if_fail (c != NULL);
     TRACE ("entering smartPlacement");
@@ -551,8 +632,6 @@ smartPlacement (Client * c, int full_x, int full_y, int full_w, int full_h)
     frame_width = frameWidth (c);
     frame_left = frameLeft(c);
     frame_top = frameTop (c);
-    test_x = 0;
-    test_y = 0;
     best_overlaps = 0.0;
     first = TRUE;
 
@@ -561,57 +640,163 @@ smartPlacement (Client * c, int full_x, int full_y, int full_w, int full_h)
     best_x = full_x + frameLeft (c);
     best_y = full_y + frameTop (c);
 
-    test_y = full_y + frameTop (c);
-    do
+    /* Number of grid steps, there is always at least one */
+    count_x = MAX (xmax - best_x, 0) / PLACEMENT_STEP + 1;
+    count_y = MAX (ymax - best_y, 0) / PLACEMENT_STEP + 1;
+
+    /* Only the windows in the placement area can overlap */
+    candidates = spatialQuery (screen_info, full_x, full_y, full_x + full_w, full_y + full_h);
+    rects = g_array_new (FALSE, FALSE, sizeof (GdkRectangle));
+    for (list = candidates; list; list = g_list_next (list))
     {
-        test_x = full_x + frameLeft (c);
-        do
+        c2 = (Client *) list->data;
+        if ((c2 != c) && (c2->type != WINDOW_DESKTOP)
+            && (c->win_workspace == c2->win_workspace)
+            && FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE))
         {
-            gfloat count_overlaps = 0.0;
-            TRACE ("analyzing %i clients", screen_info->client_count);
-            for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
+            GdkRectangle rect;
+
+            rect.x = frameX (c2);
+            rect.y = frameY (c2);
+            rect.width = frameWidth (c2);
+            rect.height = frameHeight (c2);
+            g_array_append_val (rects, rect);
+        }
+    }
+    g_list_free (candidates);
+    TRACE ("analyzing %i clients", rects->len);
+
+    xs = g_array_new (FALSE, FALSE, sizeof (gint));
+    ys = g_array_new (FALSE, FALSE, sizeof (gint));
+    step = 0;
+    g_array_append_val (xs, step);
+    g_array_append_val (ys, step);
+    step = count_x - 1;
+    g_array_append_val (xs, step);
+    step = count_y - 1;
+    g_array_append_val (ys, step);
+    for (k = 0; k < rects->len; k++)
+    {
+        r = &g_array_index (rects, GdkRectangle, k);
+        placementAddSteps (xs, r->x - frame_width, full_x, count_x);
+        placementAddSteps (xs, r->x, full_x, count_x);
+        placementAddSteps (xs, r->x + r->width - frame_width, full_x, count_x);
+        placementAddSteps (xs, r->x + r->width, full_x, count_x);
+        placementAddSteps (ys, r->y - frame_height, full_y, count_y);
+        placementAddSteps (ys, r->y, full_y, count_y);
+        placementAddSteps (ys, r->y + r->height - frame_height, full_y, count_y);
+        placementAddSteps (ys, r->y + r->height, full_y, count_y);
+    }
+    placementSortSteps (xs);
+    placementSortSteps (ys);
+
+    row = g_array_new (FALSE, FALSE, sizeof (GdkRectangle));
+    blocked = g_array_new (FALSE, FALSE, sizeof (PlacementInterval));
+    found = FALSE;
+
+    /*
+       Look for a spot with no overlap first, row by row: the windows crossing
+       the row block an interval of steps each, the first step left out by all
+       the intervals is free.
+     */
+    for (j = 0; (j < ys->len) && !found; j++)
+    {
+        PlacementInterval *interval;
+        gint y, free_step;
+
+        y = full_y + PLACEMENT_STEP * g_array_index (ys, gint, j);
+        g_array_set_size (blocked, 0);
+        for (k = 0; k < rects->len; k++)
+        {
+            PlacementInterval steps;
+
+            r = &g_array_index (rects, GdkRectangle, k);
+            if ((r->width <= 0) || (frame_width <= 0) ||
+                !segment_overlap (y, y + frame_height, r->y, r->y + r->height))
             {
-                if ((c2 != c) && (c2->type != WINDOW_DESKTOP)
-                    && (c->win_workspace == c2->win_workspace)
-                    && FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE))
-                {
-                    count_overlaps += overlap (test_x - frame_left,
-                                               test_y - frame_top,
-                                               test_x - frame_left + frame_width,
-                                               test_y - frame_top + frame_height,
-                                               frameX (c2),
-                                               frameY (c2),
-                                               frameX (c2) + frameWidth (c2),
-                                               frameY (c2) + frameHeight (c2));
-                }
+                continue;
             }
-            if (count_overlaps < 0.1)
+            /* Steps where the frame would cross the window */
+            steps.start = placementFloorDiv (r->x - frame_width + 1 - full_x + PLACEMENT_STEP - 1, PLACEMENT_STEP);
+            steps.end = placementFloorDiv (r->x + r->width - 1 - full_x, PLACEMENT_STEP);
+            steps.start = MAX (steps.start, 0);
+            steps.end = MIN (steps.end, count_x - 1);
+            if (steps.start <= steps.end)
             {
-                TRACE ("overlaps is 0 so it's the best we can get");
-                c->x = test_x;
-                c->y = test_y;
+                g_array_append_val (blocked, steps);
+            }
+        }
+        g_array_sort (blocked, placementCompareInterval);
 
-                return;
+        free_step = 0;
+        for (k = 0; k < blocked->len; k++)
+        {
+            interval = &g_array_index (blocked, PlacementInterval, k);
+            if (interval->start > free_step)
+            {
+                break;
             }
-            else if ((count_overlaps < best_overlaps) || (first))
+            free_step = MAX (free_step, interval->end + 1);
+        }
+
+        if (free_step < count_x)
+        {
+            TRACE ("overlaps is 0 so it's the best we can get");
+            c->x = best_x + PLACEMENT_STEP * free_step;
+            c->y = y + frame_top;
+            found = TRUE;
+        }
+    }
+
+    /* Every spot overlaps something, look for the least overlap */
+    for (j = 0; (j < ys->len) && !found; j++)
+    {
+        test_y = best_y + PLACEMENT_STEP * g_array_index (ys, gint, j);
+
+        /* Windows out of the row add nothing */
+        g_array_set_size (row, 0);
+        for (k = 0; k < rects->len; k++)
+        {
+            r = &g_array_index (rects, GdkRectangle, k);
+            if (segment_overlap (test_y - frame_top, test_y - frame_top + frame_height,
+                                 r->y, r->y + r->height))
             {
-                best_x = test_x;
-                best_y = test_y;
-                best_overlaps = count_overlaps;
+                g_array_append_val (row, *r);
+            }
+        }
+
+        for (i = 0; i < xs->len; i++)
+        {
+            gfloat count_overlaps = 0.0;
+
+            test_x = full_x + frame_left + PLACEMENT_STEP * g_array_index (xs, gint, i);
+            for (k = 0; k < row->len; k++)
+            {
+                r = &g_array_index (row, GdkRectangle, k);
+                count_overlaps += overlap (test_x - frame_left,
+                                           test_y - frame_top,
+                                           test_x - frame_left + frame_width,
+                                           test_y - frame_top + frame_height,
+                                           r->x,
+                                           r->y,
+                                           r->x + r->width,
+                                           r->y + r->height);
             }
-            if (first)
+            if ((count_overlaps < best_overlaps) || (first))
             {
+                c->x = test_x;
+                c->y = test_y;
+                best_overlaps = count_overlaps;
                 first = FALSE;
             }
-            test_x += 8;
         }
-        while (test_x <= xmax);
-        test_y += 8;
     }
-    while (test_y <= ymax);
 
-    c->x = best_x;
-    c->y = best_y;
+    g_array_free (blocked, TRUE);
+    g_array_free (row, TRUE);
+    g_array_free (xs, TRUE);
+    g_array_free (ys, TRUE);
+    g_array_free (rects, TRUE);
 }
 
 static void
@@ -753,8 +938,8 @@ clientFill (Client * c, int fill_type)
     Client *c2;
     GdkRectangle rect;
     XWindowChanges wc;
+    GList *candidates, *list;
     unsigned short mask;
-    guint i;
     gint cx, cy, full_x, full_y, full_w, full_h;
     gint tmp_x, tmp_y, tmp_w, tmp_h;
 
@@ -773,105 +958,126 @@ clientFill (Client * c, int fill_type)
     north_neighbour = NULL;
     south_neighbour = NULL;
 
-    for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
+    /* Fill horizontally */
+    if (fill_type & CLIENT_FILL_HORIZ)
     {
-
-        /* Filter out all windows which are not visible, or not on the same layer
-         * as well as the client window itself
-         */
-        if ((c != c2) && FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE) && (c2->win_layer == c->win_layer))
+        /* Only the windows in the same row can be east or west neighbours */
+        candidates = spatialQuery (screen_info, 0, frameY(c),
+                                   screen_info->width, frameY(c) + frameHeight(c));
+        for (list = candidates; list; list = g_list_next (list))
         {
-            /* Fill horizontally */
-            if (fill_type & CLIENT_FILL_HORIZ)
+            c2 = (Client *) list->data;
+
+            /* Filter out all windows which are not visible, or not on the same layer
+             * as well as the client window itself
+             */
+            if ((c == c2) || !FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE) || (c2->win_layer != c->win_layer))
             {
-                /*
-                 * check if the neigbour client (c2) is located
-                 * east or west of our client.
-                 */
-                if (segment_overlap (frameY(c), frameY(c) + frameHeight(c), frameY(c2), frameY(c2) + frameHeight(c2)))
+                continue;
+            }
+
+            /*
+             * check if the neigbour client (c2) is located
+             * east or west of our client.
+             */
+            if (segment_overlap (frameY(c), frameY(c) + frameHeight(c), frameY(c2), frameY(c2) + frameHeight(c2)))
+            {
+                if ((frameX(c2) + frameWidth(c2)) <= frameX(c))
                 {
-                    if ((frameX(c2) + frameWidth(c2)) <= frameX(c))
-                    {
-                        if (west_neighbour)
-                        {
-                            /* Check if c2 is closer to the client
-                             * then the west neighbour already found
-                             */
-                            if ((frameX(west_neighbour) + frameWidth(west_neighbour)) < (frameX(c2) + frameWidth(c2)))
-                            {
-                                west_neighbour = c2;
-                            }
-                        }
-                        else
-                        {
-                            west_neighbour = c2;
-                        }
-                    }
-                    if ((frameX(c) + frameWidth(c)) <= frameX(c2))
+                    if (west_neighbour)
                     {
                         /* Check if c2 is closer to the client
                          * then the west neighbour already found
                          */
-                        if (east_neighbour)
+                        if ((frameX(west_neighbour) + frameWidth(west_neighbour)) < (frameX(c2) + frameWidth(c2)))
                         {
-                            if (frameX(c2) < frameX(east_neighbour))
-                            {
-                                east_neighbour = c2;
-                            }
+                            west_neighbour = c2;
                         }
-                        else
+                    }
+                    else
+                    {
+                        west_neighbour = c2;
+                    }
+                }
+                if ((frameX(c) + frameWidth(c)) <= frameX(c2))
+                {
+                    /* Check if c2 is closer to the client
+                     * then the west neighbour already found
+                     */
+                    if (east_neighbour)
+                    {
+                        if (frameX(c2) < frameX(east_neighbour))
                         {
                             east_neighbour = c2;
                         }
                     }
+                    else
+                    {
+                        east_neighbour = c2;
+                    }
                 }
             }
+        }
+        g_list_free (candidates);
+    }
+
+    /* Fill vertically */
+    if (fill_type & CLIENT_FILL_VERT)
+    {
+        /* Only the windows in the same column can be north or south neighbours */
+        candidates = spatialQuery (screen_info, frameX(c), 0,
+                                   frameX(c) + frameWidth(c), screen_info->height);
+        for (list = candidates; list; list = g_list_next (list))
+        {
+            c2 = (Client *) list->data;
+
+            if ((c == c2) || !FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE) || (c2->win_layer != c->win_layer))
+            {
+                continue;
+            }
 
-            /* Fill vertically */
-            if (fill_type & CLIENT_FILL_VERT)
+            /* check if the neigbour client (c2) is located
+             * north or south of our client.
+             */
+            if (segment_overlap (frameX(c), frameX(c) + frameWidth(c), frameX(c2), frameX(c2) + frameWidth(c2)))
             {
-                /* check if the neigbour client (c2) is located
-                 * north or south of our client.
-                 */
-                if (segment_overlap (frameX(c), frameX(c) + frameWidth(c), frameX(c2), frameX(c2) + frameWidth(c2)))
+                if ((frameY(c2) + frameHeight(c2)) <= frameY(c))
                 {
-                    if ((frameY(c2) + frameHeight(c2)) <= frameY(c))
+                    if (north_neighbour)
                     {
-                        if (north_neighbour)
-                        {
-                            /* Check if c2 is closer to the client
-                             * then the north neighbour already found
-                             */
-                            if ((frameY(north_neighbour) + frameHeight(north_neighbour)) < (frameY(c2) + frameHeight(c2)))
-                            {
-                                north_neighbour = c2;
-                            }
-                        }
-                        else
+                        /* Check if c2 is closer to the client
+                         * then the north neighbour already found
+                         */
+                        if ((frameY(north_neighbour) + frameHeight(north_neighbour)) < (frameY(c2) + frameHeight(c2)))
                         {
                             north_neighbour = c2;
                         }
                     }
-                    if ((frameY(c) + frameHeight(c)) <= frameY(c2))
+                    else
                     {
-                        if (south_neighbour)
-                        {
-                            /* Check if c2 is closer to the client
-                             * then the south neighbour already found
-                             */
-                            if (frameY(c2) < frameY(south_neighbour))
-                            {
-                                south_neighbour = c2;
-                            }
-                        }
-                        else
+                        north_neighbour = c2;
+                    }
+                }
+                if ((frameY(c) + frameHeight(c)) <= frameY(c2))
+                {
+                    if (south_neighbour)
+                    {
+                        /* Check if c2 is closer to the client
+                         * then the south neighbour already found
+                         */
+                        if (frameY(c2) < frameY(south_neighbour))
                         {
                             south_neighbour = c2;
                         }
                     }
+                    else
+                    {
+                        south_neighbour = c2;
+                    }
                 }
             }
         }
+        g_list_free (candidates);
     }
 
     /* Compute the largest size available, based on struts, margins and Xinerama layout */
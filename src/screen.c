@@ -49,6 +49,8 @@
 #include "mywindow.h"
 #include "compositor.h"
 #include "ui_style.h"
+#include "spatial.h"
+#include "tiling.h"
 
 gboolean
 myScreenCheckWMAtom (ScreenInfo *screen_info, Atom atom)
@@ -289,6 +291,14 @@ myScreenInit (DisplayInfo *display_info, GdkScreen *gscr, unsigned long event_ma
 #endif
 
     screen_info->font_height = 0;
+    screen_info->title_cache = NULL;
+    screen_info->title_cache_hits = 0;
+    screen_info->title_cache_misses = 0;
+    screen_info->frame_redraw_queue = NULL;
+    screen_info->frame_redraw_id = 0;
+    screen_info->shapes_reused = 0;
+    screen_info->configures_suppressed = 0;
+    screen_info->notifies_suppressed = 0;
     screen_info->box_gc = None;
     screen_info->black_gc = NULL;
     screen_info->white_gc = NULL;
@@ -329,6 +339,8 @@ myScreenInit (DisplayInfo *display_info, GdkScreen *gscr, unsigned long event_ma
     screen_info->monitors_index = NULL;
     myScreenInvalidateMonitorCache (screen_info);
     myScreenRebuildMonitorIndex (screen_info);
+    tilingInit (screen_info);
+    spatialInit (screen_info);
 
     return (screen_info);
 }
@@ -343,7 +355,14 @@ myScreenClose (ScreenInfo *screen_info)
 
     display_info = screen_info->display_info;
 
+    tilingClose (screen_info);
     clientUnframeAll (screen_info);
+    spatialClose (screen_info);
+    if (screen_info->configure_timeout_id)
+    {
+        g_source_remove (screen_info->configure_timeout_id);
+        screen_info->configure_timeout_id = 0;
+    }
     compositorUnmanageScreen (screen_info);
     closeSettings (screen_info);
 
@@ -591,18 +610,15 @@ Client *
 myScreenGetClientFromWindow (ScreenInfo *screen_info, Window w, unsigned short mode)
 {
     Client *c;
-    guint i;
 
     g_return_val_if_fail (w != None, NULL);
     TRACE ("entering myScreenGetClientFromWindow");
     TRACE ("looking for (0x%lx)", w);
 
-    for (c = screen_info->clients, i = 0; i < screen_info->client_count; c = c->next, i++)
+    c = myDisplayGetClientFromWindow (screen_info->display_info, w, mode);
+    if (c && (c->screen_info == screen_info))
     {
-        if (clientGetFromWindow (c, w, mode))
-        {
-            return (c);
-        }
+        return (c);
     }
     TRACE ("no client found");
 
@@ -724,6 +740,7 @@ myScreenInvalidateMonitorCache (ScreenInfo *screen_info)
     screen_info->cache_monitor.y = -1;
     screen_info->cache_monitor.width = 0;
     screen_info->cache_monitor.height = 0;
+    screen_info->cache_monitor_index = -1;
 }
 
 /*
@@ -733,7 +750,7 @@ myScreenInvalidateMonitorCache (ScreenInfo *screen_info)
 void
 myScreenFindMonitorAtPoint (ScreenInfo *screen_info, gint x, gint y, GdkRectangle *rect)
 {
-    gint dx, dy, center_x, center_y, num_monitors, i;
+    gint dx, dy, center_x, center_y, num_monitors, i, nearest_index;
     guint32 distsquare, min_distsquare;
     GdkRectangle monitor, nearest_monitor = { G_MAXINT, G_MAXINT, 0, 0 };
 
@@ -751,6 +768,7 @@ myScreenFindMonitorAtPoint (ScreenInfo *screen_info, gint x, gint y, GdkRectangl
     }
 
     min_distsquare = G_MAXUINT32;
+    nearest_index = 0;
     num_monitors = myScreenGetNumMonitors (screen_info);
 
     for (i = 0; i < num_monitors; i++)
@@ -764,6 +782,7 @@ myScreenFindMonitorAtPoint (ScreenInfo *screen_info, gint x, gint y, GdkRectangl
             (y >= monitor.y) && (y < (monitor.y + monitor.height)))
         {
             screen_info->cache_monitor = monitor;
+            screen_info->cache_monitor_index = i;
             *rect = screen_info->cache_monitor;
             return;
         }
@@ -780,13 +799,32 @@ myScreenFindMonitorAtPoint (ScreenInfo *screen_info, gint x, gint y, GdkRectangl
         {
             min_distsquare = distsquare;
             nearest_monitor = monitor;
+            nearest_index = i;
         }
     }
 
     screen_info->cache_monitor = nearest_monitor;
+    screen_info->cache_monitor_index = nearest_index;
     *rect = screen_info->cache_monitor;
 }
 
+/*
+   Same as above but returns the logical index of the monitor, suitable
+   for myScreenGetMonitorIndex (), using the same cache.
+ */
+gint
+myScreenFindMonitorIndexAtPoint (ScreenInfo *screen_info, gint x, gint y)
+{
+    GdkRectangle rect;
+
+    g_return_val_if_fail (screen_info != NULL, 0);
+    TRACE ("entering myScreenFindMonitorIndexAtPoint");
+
+    myScreenFindMonitorAtPoint (screen_info, x, y, &rect);
+
+    return MAX (screen_info->cache_monitor_index, 0);
+}
+
 gboolean
 myScreenUpdateFontHeight (ScreenInfo *screen_info)
 {
@@ -61,6 +61,21 @@ struct _gaussian_conv {
     double  *data;
 };
 typedef struct _gaussian_conv gaussian_conv;
+
+/* One set of nine-slice shadow pieces per quantized shadow opacity */
+#define SHADOW_SLICE_LEVELS 26
+struct _ShadowSlices {
+    Picture corners;
+    Picture columns;
+    Picture rows;
+    Picture center;
+};
+typedef struct _ShadowSlices ShadowSlices;
+
+/* Server side regions kept around for reuse by the compositor */
+#ifndef REGION_POOL_SIZE
+#define REGION_POOL_SIZE 32
+#endif /* REGION_POOL_SIZE */
 #endif /* HAVE_COMPOSITOR */
 
 struct _ScreenInfo
@@ -87,6 +102,22 @@ struct _ScreenInfo
     xfwmPixmap title[TITLE_COUNT][2];
     xfwmPixmap top[TITLE_COUNT][2];
 
+    /* Rendered titles, most recently used first */
+    GList *title_cache;
+    guint title_cache_hits;
+    guint title_cache_misses;
+
+    /* Clients waiting for their frame to be redrawn */
+    GList *frame_redraw_queue;
+    guint frame_redraw_id;
+
+    /* Frame shapes left untouched as nothing changed */
+    guint shapes_reused;
+
+    /* Configure requests and synthetic ConfigureNotify left unsent */
+    guint configures_suppressed;
+    guint notifies_suppressed;
+
     /* Per screen graphic contexts */
     GC box_gc;
     GdkGC *black_gc;
@@ -118,9 +149,22 @@ struct _ScreenInfo
 
     /* Monitor search caching */
     GdkRectangle cache_monitor;
+    gint cache_monitor_index;
     gint num_monitors;
     GArray *monitors_index;
 
+    /* Tiling layouts, per workspace and monitor */
+    GHashTable *tile_layouts;
+    GArray *tile_zones;
+
+    /* Spatial index of the client frames */
+    SpatialGrid *spatial_grid;
+
+    /* Multi-window configure transactions */
+    gint configure_depth;
+    gint configure_pending;
+    guint configure_timeout_id;
+
     /* Workspace definitions */
     guint workspace_count;
     gchar **workspace_names;
@@ -161,26 +205,52 @@ struct _ScreenInfo
     Window root_overlay;
 #endif
     GList *cwindows;
+    GList *cwindows_tail;
+    GHashTable *cwindow_hash;
     Window output;
 
     gaussian_conv *gaussianMap;
     gint gaussianSize;
     guchar *shadowCorner;
     guchar *shadowTop;
+    ShadowSlices *shadowSlices[SHADOW_SLICE_LEVELS];
 
     Picture rootPicture;
     Picture rootBuffer;
     Picture blackPicture;
     Picture rootTile;
     XserverRegion allDamage;
+    GdkRectangle damage_bounds;
+    XserverRegion region_pool[REGION_POOL_SIZE];
+    gint region_pool_count;
+    guint region_requests;
+    guint region_requests_frame;
+
+    /* Damage held back from throttled windows */
+    guint throttle_timeout_id;
+    guint damage_throttled;
+
+    /* Windows with damage to fetch before the next frame */
+    guint damage_queued;
+    guint damage_events;
 
     guint wins_unredirected;
     gboolean compositor_active;
     gboolean clipChanged;
+    gboolean occlusion_dirty;
 
     gboolean damages_pending;
 
     guint compositor_timeout_id;
+    gboolean compositor_hold;
+
+    /* Frame scheduler, times in usec */
+    gint frame_interval;
+    gint frame_cost;
+    gint64 frame_last_paint;
+    guint frames_painted;
+    guint frames_immediate;
+    guint frames_aligned;
 #endif /* HAVE_COMPOSITOR */
 };
 
@@ -226,6 +296,9 @@ void                     myScreenFindMonitorAtPoint             (ScreenInfo *,
                                                                  gint,
                                                                  gint,
                                                                  GdkRectangle *);
+gint                     myScreenFindMonitorIndexAtPoint        (ScreenInfo *,
+                                                                 gint,
+                                                                 gint);
 gboolean                 myScreenUpdateFontHeight               (ScreenInfo *);
 
 #endif /* INC_SCREEN_H */
@@ -43,6 +43,8 @@
 #include "workspaces.h"
 #include "compositor.h"
 #include "ui_style.h"
+#include "tiling.h"
+#include "frame.h"
 
 #define CHANNEL_XFWM            "xfwm4"
 #define THEMERC                 "themerc"
@@ -135,6 +137,7 @@ set_settings_margin (ScreenInfo *screen_info, int idx, int value)
         default:
             break;
     }
+    tilingInvalidateZones (screen_info);
 }
 
 static void
@@ -193,6 +196,56 @@ set_placement_mode (ScreenInfo *screen_info, const char *value)
     }
 }
 
+static void
+set_tile_layout (ScreenInfo *screen_info, const char *value)
+{
+    g_return_if_fail (screen_info != NULL);
+    g_return_if_fail (value != NULL);
+
+    if (!g_ascii_strcasecmp ("master", value))
+    {
+        screen_info->params->tile_layout = TILE_LAYOUT_MASTER;
+    }
+    else if (!g_ascii_strcasecmp ("bsp", value))
+    {
+        screen_info->params->tile_layout = TILE_LAYOUT_BSP;
+    }
+    else
+    {
+        screen_info->params->tile_layout = TILE_LAYOUT_NONE;
+    }
+}
+
+static void
+set_unredirect_rules (ScreenInfo *screen_info, const char *value)
+{
+    g_return_if_fail (screen_info != NULL);
+
+    g_strfreev (screen_info->params->unredirect_rules);
+    screen_info->params->unredirect_rules = NULL;
+
+    /* A list of "wm_class:policy" separated by semicolons */
+    if ((value) && (*value))
+    {
+        screen_info->params->unredirect_rules = g_strsplit (value, ";", -1);
+    }
+}
+
+static void
+set_throttle_classes (ScreenInfo *screen_info, const char *value)
+{
+    g_return_if_fail (screen_info != NULL);
+
+    g_strfreev (screen_info->params->throttle_classes);
+    screen_info->params->throttle_classes = NULL;
+
+    /* A list of wm_class separated by semicolons */
+    if ((value) && (*value))
+    {
+        screen_info->params->throttle_classes = g_strsplit (value, ";", -1);
+    }
+}
+
 static void
 loadRcData (ScreenInfo *screen_info, Settings *rc)
 {
@@ -697,6 +750,7 @@ loadSettings (ScreenInfo *screen_info)
         {"raise_on_click", NULL, G_TYPE_BOOLEAN, TRUE},
         {"raise_on_focus", NULL, G_TYPE_BOOLEAN, TRUE},
         {"raise_with_any_button", NULL, G_TYPE_BOOLEAN, TRUE},
+        {"refresh_rate", NULL, G_TYPE_INT, TRUE},
         {"repeat_urgent_blink", NULL, G_TYPE_BOOLEAN, TRUE},
         {"resize_opacity", NULL, G_TYPE_INT, TRUE},
         {"restore_on_move", NULL, G_TYPE_BOOLEAN, TRUE},
@@ -710,11 +764,14 @@ loadSettings (ScreenInfo *screen_info)
         {"show_dock_shadow", NULL, G_TYPE_BOOLEAN, TRUE},
         {"show_frame_shadow", NULL, G_TYPE_BOOLEAN, TRUE},
         {"show_popup_shadow", NULL, G_TYPE_BOOLEAN, TRUE},
+        {"single_window_frame", NULL, G_TYPE_BOOLEAN, TRUE},
         {"snap_resist", NULL, G_TYPE_BOOLEAN, TRUE},
         {"snap_to_border", NULL, G_TYPE_BOOLEAN, TRUE},
         {"snap_to_windows", NULL, G_TYPE_BOOLEAN, TRUE},
         {"snap_width", NULL, G_TYPE_INT, TRUE},
         {"theme", NULL, G_TYPE_STRING, TRUE},
+        {"throttle_classes", NULL, G_TYPE_STRING, FALSE},
+        {"tile_layout", NULL, G_TYPE_STRING, TRUE},
         {"title_alignment", NULL, G_TYPE_STRING, TRUE},
         {"title_font", NULL, G_TYPE_STRING, FALSE},
         {"title_horizontal_offset", NULL, G_TYPE_INT, TRUE},
@@ -724,6 +781,7 @@ loadSettings (ScreenInfo *screen_info)
         {"title_vertical_offset_inactive", NULL, G_TYPE_INT, TRUE},
         {"toggle_workspaces", NULL, G_TYPE_BOOLEAN, TRUE},
         {"unredirect_overlays", NULL, G_TYPE_BOOLEAN, TRUE},
+        {"unredirect_rules", NULL, G_TYPE_STRING, FALSE},
         {"urgent_blink", NULL, G_TYPE_BOOLEAN, TRUE},
         {"use_compositing", NULL, G_TYPE_BOOLEAN, TRUE},
         {"workspace_count", NULL, G_TYPE_INT, TRUE},
@@ -772,6 +830,8 @@ loadSettings (ScreenInfo *screen_info)
         getBoolValue ("prevent_focus_stealing", rc);
     screen_info->params->raise_delay =
         getIntValue ("raise_delay", rc);
+    screen_info->params->refresh_rate =
+        CLAMP (getIntValue ("refresh_rate", rc), 0, 500);
     screen_info->params->raise_on_focus =
         getBoolValue ("raise_on_focus", rc);
     screen_info->params->focus_delay =
@@ -808,6 +868,8 @@ loadSettings (ScreenInfo *screen_info)
         getBoolValue ("show_frame_shadow", rc);
     screen_info->params->show_popup_shadow =
         getBoolValue ("show_popup_shadow", rc);
+    screen_info->params->single_window_frame =
+        getBoolValue ("single_window_frame", rc);
     screen_info->params->snap_to_border =
         getBoolValue ("snap_to_border", rc);
     screen_info->params->snap_to_windows =
@@ -845,6 +907,12 @@ loadSettings (ScreenInfo *screen_info)
 
     value = getStringValue ("placement_mode", rc);
     set_placement_mode (screen_info, value);
+    value = getStringValue ("tile_layout", rc);
+    set_tile_layout (screen_info, value);
+    value = getStringValue ("unredirect_rules", rc);
+    set_unredirect_rules (screen_info, value);
+    value = getStringValue ("throttle_classes", rc);
+    set_throttle_classes (screen_info, value);
 
     value = getStringValue ("activate_action", rc);
     set_activate_action (screen_info, value);
@@ -887,6 +955,8 @@ unloadTheme (ScreenInfo *screen_info)
 
     TRACE ("entering unloadTheme");
 
+    frameFlushTitleCache (screen_info);
+
     for (i = 0; i < SIDE_COUNT; i++)
     {
         xfwmPixmapFree (&screen_info->sides[i][ACTIVE]);
@@ -941,6 +1011,11 @@ unloadSettings (ScreenInfo *screen_info)
 
     unloadTheme (screen_info);
     unloadKeyBindings (screen_info);
+
+    g_strfreev (screen_info->params->unredirect_rules);
+    screen_info->params->unredirect_rules = NULL;
+    g_strfreev (screen_info->params->throttle_classes);
+    screen_info->params->throttle_classes = NULL;
 }
 
 static gboolean
@@ -1103,6 +1178,21 @@ cb_xfwm4_channel_property_changed(XfconfChannel *channel, const gchar *property_
                 {
                     set_placement_mode (screen_info, g_value_get_string (value));
                 }
+                else if (!strcmp (name, "tile_layout"))
+                {
+                    set_tile_layout (screen_info, g_value_get_string (value));
+                    tilingSetLayoutType (screen_info, screen_info->params->tile_layout);
+                }
+                else if (!strcmp (name, "unredirect_rules"))
+                {
+                    set_unredirect_rules (screen_info, g_value_get_string (value));
+                    compositorUpdateUnredirectRules (screen_info);
+                }
+                else if (!strcmp (name, "throttle_classes"))
+                {
+                    set_throttle_classes (screen_info, g_value_get_string (value));
+                    compositorUpdateThrottleClasses (screen_info);
+                }
                 else if ((!strcmp (name, "title_shadow_active"))
                       || (!strcmp (name, "title_shadow_inactive")))
                 {
@@ -1122,6 +1212,11 @@ cb_xfwm4_channel_property_changed(XfconfChannel *channel, const gchar *property_
                 {
                     screen_info->params->focus_delay = CLAMP (g_value_get_int (value), 5, 2000);
                 }
+                else if (!strcmp (name, "refresh_rate"))
+                {
+                    screen_info->params->refresh_rate = CLAMP (g_value_get_int (value), 0, 500);
+                    compositorUpdateRefreshRate (screen_info);
+                }
                 else if (!strcmp (name, "snap_width"))
                 {
                     screen_info->params->snap_width = CLAMP (g_value_get_int (value), 5, 100);
@@ -1311,6 +1406,11 @@ cb_xfwm4_channel_property_changed(XfconfChannel *channel, const gchar *property_
                     screen_info->params->show_frame_shadow = g_value_get_boolean (value);
                     reloadScreenSettings (screen_info, UPDATE_FRAME);
                 }
+                else if (!strcmp (name, "single_window_frame"))
+                {
+                    /* Only applies to windows framed from now on */
+                    screen_info->params->single_window_frame = g_value_get_boolean (value);
+                }
                 else if (!strcmp (name, "show_popup_shadow"))
                 {
                     screen_info->params->show_popup_shadow = g_value_get_boolean (value);
@@ -165,6 +165,8 @@ struct _XfwmParams
 {
     MyKey keys[KEY_COUNT];
     gchar button_layout[BUTTON_STRING_COUNT + 1];
+    gchar **unredirect_rules;
+    gchar **throttle_classes;
     int xfwm_margins[4];
     int activate_action;
     int button_offset;
@@ -180,6 +182,7 @@ struct _XfwmParams
     int placement_ratio;
     int popup_opacity;
     int raise_delay;
+    int refresh_rate;
     int resize_opacity;
     int restore_on_move;
     int shadow_delta_height;
@@ -188,6 +191,7 @@ struct _XfwmParams
     int shadow_delta_y;
     int shadow_opacity;
     int snap_width;
+    int tile_layout;
     int title_alignment;
     int title_horizontal_offset;
     int title_shadow[2];
@@ -215,6 +219,7 @@ struct _XfwmParams
     gboolean show_dock_shadow;
     gboolean show_frame_shadow;
     gboolean show_popup_shadow;
+    gboolean single_window_frame;
     gboolean snap_resist;
     gboolean snap_to_border;
     gboolean snap_to_windows;
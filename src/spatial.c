@@ -0,0 +1,309 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2011 Olivier Fourdan
+
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <X11/Xlib.h>
+#include <glib.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include "screen.h"
+#include "client.h"
+#include "frame.h"
+#include "spatial.h"
+
+#define SPATIAL_CELL(grid, col, row)    ((grid)->cells[(row) * (grid)->cols + (col)])
+
+static gint
+spatialCompareSerial (gconstpointer a, gconstpointer b)
+{
+    const Client *c1 = a;
+    const Client *c2 = b;
+
+    /* Same order as screen_info->clients */
+    if (c1->serial < c2->serial)
+    {
+        return -1;
+    }
+    return (c1->serial > c2->serial);
+}
+
+static void
+spatialGetCells (SpatialGrid *grid, gint x1, gint y1, gint x2, gint y2,
+                 gint *col1, gint *row1, gint *col2, gint *row2)
+{
+    *col1 = CLAMP (x1, 0, grid->width - 1) / SPATIAL_CELL_SIZE;
+    *row1 = CLAMP (y1, 0, grid->height - 1) / SPATIAL_CELL_SIZE;
+    *col2 = CLAMP (x2, 0, grid->width - 1) / SPATIAL_CELL_SIZE;
+    *row2 = CLAMP (y2, 0, grid->height - 1) / SPATIAL_CELL_SIZE;
+}
+
+static void
+spatialUnlinkClient (SpatialGrid *grid, Client *c)
+{
+    gint col, row;
+
+    if (!c->spatial_indexed)
+    {
+        return;
+    }
+
+    for (row = c->spatial_cells[1]; row <= c->spatial_cells[3]; row++)
+    {
+        for (col = c->spatial_cells[0]; col <= c->spatial_cells[2]; col++)
+        {
+            SPATIAL_CELL (grid, col, row) =
+                g_list_remove (SPATIAL_CELL (grid, col, row), c);
+        }
+    }
+    c->spatial_indexed = FALSE;
+}
+
+static void
+spatialLinkClient (SpatialGrid *grid, Client *c)
+{
+    gint cells[4];
+    gint col, row;
+
+    spatialGetCells (grid, frameX (c), frameY (c),
+                     frameX (c) + frameWidth (c), frameY (c) + frameHeight (c),
+                     &cells[0], &cells[1], &cells[2], &cells[3]);
+
+    if ((c->spatial_indexed) &&
+        (cells[0] == c->spatial_cells[0]) && (cells[1] == c->spatial_cells[1]) &&
+        (cells[2] == c->spatial_cells[2]) && (cells[3] == c->spatial_cells[3]))
+    {
+        /* Still in the same cells */
+        return;
+    }
+
+    spatialUnlinkClient (grid, c);
+    for (row = cells[1]; row <= cells[3]; row++)
+    {
+        for (col = cells[0]; col <= cells[2]; col++)
+        {
+            SPATIAL_CELL (grid, col, row) =
+                g_list_prepend (SPATIAL_CELL (grid, col, row), c);
+        }
+    }
+    c->spatial_cells[0] = cells[0];
+    c->spatial_cells[1] = cells[1];
+    c->spatial_cells[2] = cells[2];
+    c->spatial_cells[3] = cells[3];
+    c->spatial_indexed = TRUE;
+}
+
+static void
+spatialFreeCells (SpatialGrid *grid)
+{
+    gint i;
+
+    for (i = 0; i < grid->cols * grid->rows; i++)
+    {
+        g_list_free (grid->cells[i]);
+    }
+    g_free (grid->cells);
+    grid->cells = NULL;
+}
+
+/*
+   The grid follows the screen size, rebuild it from scratch when the
+   screen is resized rather than tracking every path that changes it.
+ */
+static SpatialGrid *
+spatialGetGrid (ScreenInfo *screen_info)
+{
+    SpatialGrid *grid;
+    Client *c;
+    guint i;
+
+    grid = screen_info->spatial_grid;
+    if ((grid->width == screen_info->width) && (grid->height == screen_info->height))
+    {
+        return grid;
+    }
+
+    TRACE ("rebuilding spatial grid for %ix%i", screen_info->width, screen_info->height);
+    spatialFreeCells (grid);
+    grid->width = MAX (screen_info->width, 1);
+    grid->height = MAX (screen_info->height, 1);
+    grid->cols = (grid->width + SPATIAL_CELL_SIZE - 1) / SPATIAL_CELL_SIZE;
+    grid->rows = (grid->height + SPATIAL_CELL_SIZE - 1) / SPATIAL_CELL_SIZE;
+    grid->cells = g_new0 (GList *, grid->cols * grid->rows);
+
+    for (c = screen_info->clients, i = 0; i < screen_info->client_count; c = c->next, i++)
+    {
+        if (c->spatial_indexed)
+        {
+            c->spatial_indexed = FALSE;
+            spatialLinkClient (grid, c);
+        }
+    }
+
+    return grid;
+}
+
+void
+spatialInit (ScreenInfo *screen_info)
+{
+    SpatialGrid *grid;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering spatialInit");
+
+    grid = g_new0 (SpatialGrid, 1);
+    screen_info->spatial_grid = grid;
+    /* Sized on first use */
+    grid->width = -1;
+    grid->height = -1;
+}
+
+void
+spatialClose (ScreenInfo *screen_info)
+{
+    SpatialGrid *grid;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering spatialClose");
+
+    grid = screen_info->spatial_grid;
+    if (grid)
+    {
+        spatialFreeCells (grid);
+        g_list_free (grid->struts);
+        g_free (grid);
+        screen_info->spatial_grid = NULL;
+    }
+}
+
+void
+spatialUpdateClient (Client *c)
+{
+    SpatialGrid *grid;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering spatialUpdateClient");
+
+    grid = c->screen_info->spatial_grid;
+    if ((grid == NULL) || !FLAG_TEST (c->xfwm_flags, XFWM_FLAG_MANAGED))
+    {
+        return;
+    }
+
+    grid = spatialGetGrid (c->screen_info);
+    spatialLinkClient (grid, c);
+
+    if (FLAG_TEST (c->flags, CLIENT_FLAG_HAS_STRUT))
+    {
+        if (!g_list_find (grid->struts, c))
+        {
+            grid->struts = g_list_insert_sorted (grid->struts, c, spatialCompareSerial);
+        }
+    }
+    else
+    {
+        grid->struts = g_list_remove (grid->struts, c);
+    }
+}
+
+void
+spatialRemoveClient (Client *c)
+{
+    SpatialGrid *grid;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering spatialRemoveClient");
+
+    grid = c->screen_info->spatial_grid;
+    if (grid == NULL)
+    {
+        return;
+    }
+
+    spatialUnlinkClient (grid, c);
+    grid->struts = g_list_remove (grid->struts, c);
+}
+
+/*
+   Returns the clients whose frame may touch the given rectangle (bounds
+   included), in the order of screen_info->clients so that callers get
+   the same result as when walking the whole list. This is a superset,
+   callers still have to check the actual geometry. The list must be
+   freed with g_list_free().
+ */
+GList *
+spatialQuery (ScreenInfo *screen_info, gint x1, gint y1, gint x2, gint y2)
+{
+    SpatialGrid *grid;
+    GList *result, *list;
+    gint col1, row1, col2, row2;
+    gint col, row;
+
+    g_return_val_if_fail (screen_info != NULL, NULL);
+    TRACE ("entering spatialQuery (%i,%i)-(%i,%i)", x1, y1, x2, y2);
+
+    if (screen_info->spatial_grid == NULL)
+    {
+        return NULL;
+    }
+
+    grid = spatialGetGrid (screen_info);
+    spatialGetCells (grid, x1, y1, x2, y2, &col1, &row1, &col2, &row2);
+
+    /* Clients spanning several cells are reported once */
+    grid->serial++;
+    result = NULL;
+    for (row = row1; row <= row2; row++)
+    {
+        for (col = col1; col <= col2; col++)
+        {
+            for (list = SPATIAL_CELL (grid, col, row); list; list = g_list_next (list))
+            {
+                Client *c = (Client *) list->data;
+                if (c->spatial_mark != grid->serial)
+                {
+                    c->spatial_mark = grid->serial;
+                    result = g_list_prepend (result, c);
+                }
+            }
+        }
+    }
+
+    return g_list_sort (result, spatialCompareSerial);
+}
+
+/*
+   Clients having struts, in the order of screen_info->clients. The list
+   belongs to the grid and must not be freed.
+ */
+GList *
+spatialGetStruts (ScreenInfo *screen_info)
+{
+    g_return_val_if_fail (screen_info != NULL, NULL);
+
+    if (screen_info->spatial_grid == NULL)
+    {
+        return NULL;
+    }
+    return screen_info->spatial_grid->struts;
+}
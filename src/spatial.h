@@ -0,0 +1,67 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2011 Olivier Fourdan
+
+ */
+
+#ifndef INC_SPATIAL_H
+#define INC_SPATIAL_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include "screen.h"
+#include "client.h"
+
+#ifndef SPATIAL_CELL_SIZE
+#define SPATIAL_CELL_SIZE               128
+#endif
+
+/*
+ * Uniform grid over the screen. Each cell lists the clients whose frame
+ * touches it, frames hanging off screen are clamped to the border cells.
+ * Clients having struts are also kept in a separate list, since struts
+ * are not tied to the frame geometry.
+ */
+struct _SpatialGrid
+{
+    gint width;
+    gint height;
+    gint cols;
+    gint rows;
+    GList **cells;
+    GList *struts;
+    guint serial;
+};
+
+void                     spatialInit                            (ScreenInfo *);
+void                     spatialClose                           (ScreenInfo *);
+void                     spatialUpdateClient                    (Client *);
+void                     spatialRemoveClient                    (Client *);
+GList                   *spatialQuery                           (ScreenInfo *,
+                                                                 gint,
+                                                                 gint,
+                                                                 gint,
+                                                                 gint);
+GList                   *spatialGetStruts                       (ScreenInfo *);
+
+#endif /* INC_SPATIAL_H */
@@ -39,6 +39,7 @@
 #include "transients.h"
 #include "frame.h"
 #include "focus.h"
+#include "spatial.h"
 
 static guint raise_timeout = 0;
 
@@ -252,13 +253,14 @@ clientGetBottomMost (ScreenInfo *screen_info, guint layer, Client * exclude)
 Client *
 clientAtPosition (ScreenInfo *screen_info, int x, int y, GList * exclude_list)
 {
-    GList *list;
+    GList *candidates, *found, *list;
     Client *c, *c2;
 
     TRACE ("entering clientAtPosition");
 
-    c = NULL;
-    for (list = g_list_last (screen_info->windows_stack); list; list = g_list_previous (list))
+    found = NULL;
+    candidates = spatialQuery (screen_info, x, y, x, y);
+    for (list = candidates; list; list = g_list_next (list))
     {
         c2 = (Client *) list->data;
         if ((frameX (c2) <= x) && (frameX (c2) + frameWidth (c2) >= x)
@@ -266,12 +268,32 @@ clientAtPosition (ScreenInfo *screen_info, int x, int y, GList * exclude_list)
         {
             if (clientSelectMask (c2, NULL, SEARCH_INCLUDE_SKIP_PAGER | SEARCH_INCLUDE_SKIP_TASKBAR, WINDOW_REGULAR_FOCUSABLE)
                 && !g_list_find (exclude_list, (gconstpointer) c2))
+            {
+                found = g_list_prepend (found, c2);
+            }
+        }
+    }
+    g_list_free (candidates);
+
+    /* Only walk the stack when there is more than one window to choose from */
+    c = NULL;
+    if ((found) && !g_list_next (found))
+    {
+        c = (Client *) found->data;
+    }
+    else if (found)
+    {
+        for (list = g_list_last (screen_info->windows_stack); list; list = g_list_previous (list))
+        {
+            c2 = (Client *) list->data;
+            if (g_list_find (found, (gconstpointer) c2))
             {
                 c = c2;
                 break;
             }
         }
     }
+    g_list_free (found);
 
     return c;
 }
@@ -0,0 +1,1358 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2011 Olivier Fourdan
+
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <glib.h>
+#include <gdk/gdk.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include "screen.h"
+#include "client.h"
+#include "focus.h"
+#include "frame.h"
+#include "placement.h"
+#include "transients.h"
+#include "tiling.h"
+
+#define TILE_LAYOUT_KEY(ws, monitor)    GUINT_TO_POINTER (((ws) << 8) | ((monitor) & 0xff))
+
+gboolean
+tilingIsTileable (Client *c)
+{
+    return (FLAG_TEST_AND_NOT (c->xfwm_flags, XFWM_FLAG_HAS_RESIZE | XFWM_FLAG_IS_RESIZABLE,
+                                              XFWM_FLAG_LEGACY_FULLSCREEN)
+            && (c->type == WINDOW_NORMAL)
+            && !FLAG_TEST (c->flags, CLIENT_FLAG_STICKY | CLIENT_FLAG_FULLSCREEN)
+            && !clientIsTransientOrModal (c));
+}
+
+static gboolean
+tilingIsShown (Client *c)
+{
+    /* Iconified windows keep their slot but give their space away */
+    return !FLAG_TEST (c->flags, CLIENT_FLAG_ICONIFIED);
+}
+
+static void
+tilingBuildZones (ScreenInfo *screen_info, gint monitor, TileZones *zones)
+{
+    GdkRectangle *zone;
+    GdkRectangle area;
+    gint hw, hh, tw;
+
+    gdk_screen_get_monitor_geometry (screen_info->gscr,
+                                     myScreenGetMonitorIndex (screen_info, monitor), &zones->monitor);
+
+    area.x = MAX (screen_info->params->xfwm_margins[STRUTS_LEFT], zones->monitor.x);
+    area.y = MAX (screen_info->params->xfwm_margins[STRUTS_TOP], zones->monitor.y);
+    area.width = MIN (screen_info->width - screen_info->params->xfwm_margins[STRUTS_RIGHT],
+                      zones->monitor.x + zones->monitor.width) - area.x;
+    area.height = MIN (screen_info->height - screen_info->params->xfwm_margins[STRUTS_BOTTOM],
+                       zones->monitor.y + zones->monitor.height) - area.y;
+
+    /* Do not cover struts */
+    clientMaxSpace (screen_info, &area.x, &area.y, &area.width, &area.height);
+
+    hw = area.width / 2;
+    hh = area.height / 2;
+    tw = area.width / 3;
+    zone = zones->zone;
+
+    zone[TILE_ZONE_MAXIMIZE] = area;
+    zone[TILE_ZONE_LEFT] = area;
+    zone[TILE_ZONE_LEFT].width = hw;
+    zone[TILE_ZONE_RIGHT] = area;
+    zone[TILE_ZONE_RIGHT].x = area.x + hw;
+    zone[TILE_ZONE_RIGHT].width = area.width - hw;
+
+    zone[TILE_ZONE_TOP_LEFT] = zone[TILE_ZONE_LEFT];
+    zone[TILE_ZONE_TOP_LEFT].height = hh;
+    zone[TILE_ZONE_TOP_RIGHT] = zone[TILE_ZONE_RIGHT];
+    zone[TILE_ZONE_TOP_RIGHT].height = hh;
+    zone[TILE_ZONE_BOTTOM_LEFT] = zone[TILE_ZONE_LEFT];
+    zone[TILE_ZONE_BOTTOM_LEFT].y = area.y + hh;
+    zone[TILE_ZONE_BOTTOM_LEFT].height = area.height - hh;
+    zone[TILE_ZONE_BOTTOM_RIGHT] = zone[TILE_ZONE_RIGHT];
+    zone[TILE_ZONE_BOTTOM_RIGHT].y = area.y + hh;
+    zone[TILE_ZONE_BOTTOM_RIGHT].height = area.height - hh;
+
+    zone[TILE_ZONE_THIRD_LEFT] = area;
+    zone[TILE_ZONE_THIRD_LEFT].width = tw;
+    zone[TILE_ZONE_THIRD_CENTER] = area;
+    zone[TILE_ZONE_THIRD_CENTER].x = area.x + tw;
+    zone[TILE_ZONE_THIRD_CENTER].width = area.width - 2 * tw;
+    zone[TILE_ZONE_THIRD_RIGHT] = area;
+    zone[TILE_ZONE_THIRD_RIGHT].x = area.x + area.width - tw;
+    zone[TILE_ZONE_THIRD_RIGHT].width = tw;
+}
+
+static TileZones *
+tilingGetZones (ScreenInfo *screen_info, gint monitor)
+{
+    TileZones zones;
+    gint i, num_monitors;
+
+    num_monitors = myScreenGetNumMonitors (screen_info);
+    if (screen_info->tile_zones == NULL)
+    {
+        TRACE ("rebuilding snap zones for %i monitors", num_monitors);
+        screen_info->tile_zones = g_array_sized_new (FALSE, TRUE, sizeof (TileZones), num_monitors);
+        for (i = 0; i < num_monitors; i++)
+        {
+            tilingBuildZones (screen_info, i, &zones);
+            g_array_append_val (screen_info->tile_zones, zones);
+        }
+    }
+    monitor = CLAMP (monitor, 0, (gint) screen_info->tile_zones->len - 1);
+
+    return &g_array_index (screen_info->tile_zones, TileZones, monitor);
+}
+
+static TileNode *
+tilingNodeNew (Client *c)
+{
+    TileNode *node;
+
+    node = g_new0 (TileNode, 1);
+    node->c = c;
+    node->ratio = TILE_DEFAULT_RATIO;
+    node->weight = 1.0;
+
+    return node;
+}
+
+static void
+tilingNodeFree (TileNode *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    tilingNodeFree (node->child[0]);
+    tilingNodeFree (node->child[1]);
+    g_free (node);
+}
+
+static gboolean
+tilingNodeIsShown (TileNode *node)
+{
+    if (node->c)
+    {
+        return tilingIsShown (node->c);
+    }
+
+    return (tilingNodeIsShown (node->child[0]) || tilingNodeIsShown (node->child[1]));
+}
+
+static void
+tilingNodeReplace (TileLayout *layout, TileNode *old, TileNode *new)
+{
+    TileNode *parent;
+
+    parent = old->parent;
+    new->parent = parent;
+    if (parent == NULL)
+    {
+        layout->root = new;
+    }
+    else if (parent->child[0] == old)
+    {
+        parent->child[0] = new;
+    }
+    else
+    {
+        parent->child[1] = new;
+    }
+}
+
+static void
+tilingNodeSplit (TileLayout *layout, TileNode *leaf, Client *c, gint side)
+{
+    TileNode *split;
+    TileNode *node;
+
+    node = tilingNodeNew (c);
+    split = tilingNodeNew (NULL);
+    split->area = leaf->area;
+    tilingNodeReplace (layout, leaf, split);
+
+    if (side == TILE_NO_SIDE)
+    {
+        /* Split along the longest axis, new window goes right or below */
+        split->vertical = (leaf->area.height > leaf->area.width);
+        split->child[0] = leaf;
+        split->child[1] = node;
+    }
+    else
+    {
+        split->vertical = ((side == SIDE_TOP) || (side == SIDE_BOTTOM));
+        if ((side == SIDE_LEFT) || (side == SIDE_TOP))
+        {
+            split->child[0] = node;
+            split->child[1] = leaf;
+        }
+        else
+        {
+            split->child[0] = leaf;
+            split->child[1] = node;
+        }
+    }
+    leaf->parent = split;
+    node->parent = split;
+    c->tile_node = node;
+}
+
+static void
+tilingNodeRemove (TileLayout *layout, TileNode *leaf)
+{
+    TileNode *parent;
+    TileNode *sibling;
+
+    parent = leaf->parent;
+    if (parent == NULL)
+    {
+        layout->root = NULL;
+    }
+    else
+    {
+        sibling = (parent->child[0] == leaf) ? parent->child[1] : parent->child[0];
+        tilingNodeReplace (layout, parent, sibling);
+        g_free (parent);
+    }
+    g_free (leaf);
+}
+
+static TileNode *
+tilingNodeAtPoint (TileNode *node, gint x, gint y)
+{
+    TileNode *first;
+
+    while (node->c == NULL)
+    {
+        first = node->child[0];
+        if (tilingNodeIsShown (first)
+            && (x >= first->area.x) && (x < first->area.x + first->area.width)
+            && (y >= first->area.y) && (y < first->area.y + first->area.height))
+        {
+            node = first;
+        }
+        else
+        {
+            node = node->child[1];
+        }
+    }
+
+    return node;
+}
+
+static TileNode *
+tilingNodeLast (TileNode *node)
+{
+    while (node->c == NULL)
+    {
+        node = node->child[1];
+    }
+
+    return node;
+}
+
+static void
+tilingNodeLayout (TileNode *node, GdkRectangle *area)
+{
+    GdkRectangle first, second;
+
+    node->area = *area;
+    if (node->c)
+    {
+        return;
+    }
+
+    first = *area;
+    second = *area;
+    if (tilingNodeIsShown (node->child[0]) && tilingNodeIsShown (node->child[1]))
+    {
+        if (node->vertical)
+        {
+            first.height = (gint) (area->height * node->ratio);
+            second.y = area->y + first.height;
+            second.height = area->height - first.height;
+        }
+        else
+        {
+            first.width = (gint) (area->width * node->ratio);
+            second.x = area->x + first.width;
+            second.width = area->width - first.width;
+        }
+    }
+    tilingNodeLayout (node->child[0], &first);
+    tilingNodeLayout (node->child[1], &second);
+}
+
+static void
+tilingMasterLayout (TileLayout *layout, GdkRectangle *area)
+{
+    GdkRectangle column[TILE_COLUMN_COUNT];
+    GdkRectangle *rect;
+    GList *list;
+    Client *c;
+    gdouble total[TILE_COLUMN_COUNT];
+    gdouble sum;
+    gint count[TILE_COLUMN_COUNT];
+    gint i, width;
+
+    for (i = 0; i < TILE_COLUMN_COUNT; i++)
+    {
+        count[i] = 0;
+        total[i] = 0.0;
+        for (list = layout->columns[i]; list; list = g_list_next (list))
+        {
+            c = (Client *) list->data;
+            if (tilingIsShown (c))
+            {
+                count[i]++;
+                total[i] += c->tile_node->weight;
+            }
+        }
+        column[i] = *area;
+    }
+
+    /*
+     * When tiling is only driven by drags, a lonely column keeps its half
+     * of the monitor, just like a plain edge snap would. Otherwise the
+     * populated column takes all the room.
+     */
+    if ((count[TILE_COLUMN_MASTER] && count[TILE_COLUMN_STACK])
+        || (layout->screen_info->params->tile_layout == TILE_LAYOUT_NONE))
+    {
+        width = (gint) (area->width * layout->master_ratio);
+        column[TILE_COLUMN_MASTER].width = width;
+        column[TILE_COLUMN_STACK].x = area->x + width;
+        column[TILE_COLUMN_STACK].width = area->width - width;
+    }
+
+    /* Rows share their column according to their weight */
+    for (i = 0; i < TILE_COLUMN_COUNT; i++)
+    {
+        sum = 0.0;
+        for (list = layout->columns[i]; list; list = g_list_next (list))
+        {
+            c = (Client *) list->data;
+            rect = &c->tile_node->area;
+            *rect = column[i];
+            if (!tilingIsShown (c))
+            {
+                continue;
+            }
+            rect->y = column[i].y + (gint) (column[i].height * sum / total[i]);
+            sum += c->tile_node->weight;
+            rect->height = column[i].y + (gint) (column[i].height * sum / total[i]) - rect->y;
+        }
+    }
+}
+
+static TileLayout *
+tilingLookupLayout (ScreenInfo *screen_info, guint ws, gint monitor, gboolean create)
+{
+    TileLayout *layout;
+
+    layout = g_hash_table_lookup (screen_info->tile_layouts, TILE_LAYOUT_KEY (ws, monitor));
+    if ((layout == NULL) && (create))
+    {
+        layout = g_new0 (TileLayout, 1);
+        layout->screen_info = screen_info;
+        layout->workspace = ws;
+        layout->monitor = monitor;
+        layout->type = screen_info->params->tile_layout;
+        if (layout->type == TILE_LAYOUT_NONE)
+        {
+            layout->type = TILE_LAYOUT_MASTER;
+        }
+        layout->master_ratio = TILE_DEFAULT_RATIO;
+        g_hash_table_insert (screen_info->tile_layouts, TILE_LAYOUT_KEY (ws, monitor), layout);
+    }
+
+    return layout;
+}
+
+static void
+tilingFreeEdges (TileLayout *layout)
+{
+    TileEdge *edge;
+    GList *list;
+
+    for (list = layout->edges; list; list = g_list_next (list))
+    {
+        edge = (TileEdge *) list->data;
+        g_list_free (edge->before);
+        g_list_free (edge->after);
+        g_free (edge);
+    }
+    g_list_free (layout->edges);
+    layout->edges = NULL;
+}
+
+static void
+tilingAddEdge (TileLayout *layout, Client *c, gboolean vertical, gboolean after)
+{
+    GdkRectangle *rect;
+    TileEdge *edge, *other;
+    GList *list, *next;
+    gint pos, start, end;
+
+    rect = &c->tile_node->area;
+    if (vertical)
+    {
+        pos = (after ? rect->x : rect->x + rect->width);
+        start = rect->y;
+        end = rect->y + rect->height;
+    }
+    else
+    {
+        pos = (after ? rect->y : rect->y + rect->height);
+        start = rect->x;
+        end = rect->x + rect->width;
+    }
+
+    edge = g_new0 (TileEdge, 1);
+    edge->vertical = vertical;
+    edge->pos = pos;
+    edge->start = start;
+    edge->end = end;
+    if (after)
+    {
+        edge->after = g_list_prepend (NULL, c);
+    }
+    else
+    {
+        edge->before = g_list_prepend (NULL, c);
+    }
+
+    /* Merge with every edge on the same line that overlaps or touches it */
+    for (list = layout->edges; list; list = next)
+    {
+        next = g_list_next (list);
+        other = (TileEdge *) list->data;
+        if ((other->vertical != vertical) || (other->pos != pos)
+            || (other->end < edge->start) || (other->start > edge->end))
+        {
+            continue;
+        }
+        edge->start = MIN (edge->start, other->start);
+        edge->end = MAX (edge->end, other->end);
+        edge->before = g_list_concat (edge->before, other->before);
+        edge->after = g_list_concat (edge->after, other->after);
+        g_free (other);
+        layout->edges = g_list_delete_link (layout->edges, list);
+    }
+    layout->edges = g_list_prepend (layout->edges, edge);
+}
+
+/* Rebuild the graph of the edges shared between the tiles of the layout */
+static void
+tilingBuildEdges (TileLayout *layout)
+{
+    TileEdge *edge;
+    GList *list, *next;
+    Client *c;
+
+    tilingFreeEdges (layout);
+    for (list = layout->clients; list; list = g_list_next (list))
+    {
+        c = (Client *) list->data;
+        if (!tilingIsShown (c))
+        {
+            continue;
+        }
+        tilingAddEdge (layout, c, TRUE, FALSE);
+        tilingAddEdge (layout, c, TRUE, TRUE);
+        tilingAddEdge (layout, c, FALSE, FALSE);
+        tilingAddEdge (layout, c, FALSE, TRUE);
+    }
+
+    /* Borders of the layout are not shared with anything */
+    for (list = layout->edges; list; list = next)
+    {
+        next = g_list_next (list);
+        edge = (TileEdge *) list->data;
+        if ((edge->before == NULL) || (edge->after == NULL))
+        {
+            g_list_free (edge->before);
+            g_list_free (edge->after);
+            g_free (edge);
+            layout->edges = g_list_delete_link (layout->edges, list);
+        }
+    }
+}
+
+static TileEdge *
+tilingFindEdge (TileLayout *layout, Client *c, gboolean vertical, gboolean after)
+{
+    TileEdge *edge;
+    GList *list;
+
+    for (list = layout->edges; list; list = g_list_next (list))
+    {
+        edge = (TileEdge *) list->data;
+        if ((edge->vertical == vertical) && g_list_find (after ? edge->after : edge->before, c))
+        {
+            return edge;
+        }
+    }
+
+    return NULL;
+}
+
+/* Move the edge, resizing the tiles on both sides, returns the actual position */
+static gint
+tilingMoveEdge (TileEdge *edge, gint pos)
+{
+    GdkRectangle *rect;
+    GList *list;
+    gint min, max;
+
+    min = G_MININT;
+    max = G_MAXINT;
+    for (list = edge->before; list; list = g_list_next (list))
+    {
+        rect = &((Client *) list->data)->tile_node->area;
+        min = MAX (min, (edge->vertical ? rect->x : rect->y) + TILE_MIN_SIZE);
+    }
+    for (list = edge->after; list; list = g_list_next (list))
+    {
+        rect = &((Client *) list->data)->tile_node->area;
+        max = MIN (max, (edge->vertical ? rect->x + rect->width : rect->y + rect->height) - TILE_MIN_SIZE);
+    }
+    if (min > max)
+    {
+        return edge->pos;
+    }
+    pos = CLAMP (pos, min, max);
+
+    for (list = edge->before; list; list = g_list_next (list))
+    {
+        rect = &((Client *) list->data)->tile_node->area;
+        if (edge->vertical)
+        {
+            rect->width = pos - rect->x;
+        }
+        else
+        {
+            rect->height = pos - rect->y;
+        }
+    }
+    for (list = edge->after; list; list = g_list_next (list))
+    {
+        rect = &((Client *) list->data)->tile_node->area;
+        if (edge->vertical)
+        {
+            rect->width += rect->x - pos;
+            rect->x = pos;
+        }
+        else
+        {
+            rect->height += rect->y - pos;
+            rect->y = pos;
+        }
+    }
+    edge->pos = pos;
+
+    return pos;
+}
+
+static void
+tilingFreeLayout (gpointer data)
+{
+    TileLayout *layout;
+    GList *list;
+    Client *c;
+    gint i;
+
+    layout = (TileLayout *) data;
+    tilingFreeEdges (layout);
+    if (layout->type == TILE_LAYOUT_BSP)
+    {
+        tilingNodeFree (layout->root);
+    }
+    for (list = layout->clients; list; list = g_list_next (list))
+    {
+        c = (Client *) list->data;
+        if (layout->type != TILE_LAYOUT_BSP)
+        {
+            g_free (c->tile_node);
+        }
+        c->tile_node = NULL;
+        c->tile_layout = NULL;
+    }
+    for (i = 0; i < TILE_COLUMN_COUNT; i++)
+    {
+        g_list_free (layout->columns[i]);
+    }
+    g_list_free (layout->clients);
+    g_free (layout);
+}
+
+static void
+tilingInsert (TileLayout *layout, Client *c, gint x, gint y, gint side)
+{
+    Client *focus;
+    TileNode *leaf;
+    gint column;
+
+    tilingFreeEdges (layout);
+    c->tile_layout = layout;
+    layout->clients = g_list_append (layout->clients, c);
+
+    if (layout->type == TILE_LAYOUT_BSP)
+    {
+        if (layout->root == NULL)
+        {
+            c->tile_node = tilingNodeNew (c);
+            layout->root = c->tile_node;
+            return;
+        }
+
+        leaf = NULL;
+        if (side != TILE_NO_SIDE)
+        {
+            leaf = tilingNodeAtPoint (layout->root, x, y);
+        }
+        else
+        {
+            focus = clientGetFocus ();
+            if (focus && (focus != c) && (focus->tile_layout == layout))
+            {
+                leaf = focus->tile_node;
+            }
+        }
+        if (leaf == NULL)
+        {
+            leaf = tilingNodeLast (layout->root);
+        }
+        tilingNodeSplit (layout, leaf, c, side);
+    }
+    else
+    {
+        c->tile_node = tilingNodeNew (c);
+        if (side == SIDE_LEFT)
+        {
+            column = TILE_COLUMN_MASTER;
+        }
+        else if (side == SIDE_RIGHT)
+        {
+            column = TILE_COLUMN_STACK;
+        }
+        else
+        {
+            column = (layout->columns[TILE_COLUMN_MASTER] ? TILE_COLUMN_STACK : TILE_COLUMN_MASTER);
+        }
+        layout->columns[column] = g_list_append (layout->columns[column], c);
+    }
+}
+
+static void
+tilingRemove (TileLayout *layout, Client *c)
+{
+    GList *first;
+    gint i;
+
+    tilingFreeEdges (layout);
+    layout->clients = g_list_remove (layout->clients, c);
+
+    if (layout->type == TILE_LAYOUT_BSP)
+    {
+        tilingNodeRemove (layout, c->tile_node);
+    }
+    else
+    {
+        for (i = 0; i < TILE_COLUMN_COUNT; i++)
+        {
+            layout->columns[i] = g_list_remove (layout->columns[i], c);
+        }
+        g_free (c->tile_node);
+
+        /* Automatic layouts never leave the master column empty */
+        first = layout->columns[TILE_COLUMN_STACK];
+        if ((layout->screen_info->params->tile_layout != TILE_LAYOUT_NONE)
+            && (layout->columns[TILE_COLUMN_MASTER] == NULL) && (first))
+        {
+            ((Client *) first->data)->tile_node->weight = 1.0;
+            layout->columns[TILE_COLUMN_MASTER] = g_list_append (NULL, first->data);
+            layout->columns[TILE_COLUMN_STACK] = g_list_delete_link (first, first);
+        }
+    }
+    c->tile_node = NULL;
+    c->tile_layout = NULL;
+}
+
+/* Remove the client from its layout, returns the layout if it still exists */
+static TileLayout *
+tilingDetach (Client *c)
+{
+    TileLayout *layout;
+
+    layout = c->tile_layout;
+    if (layout == NULL)
+    {
+        return NULL;
+    }
+
+    tilingRemove (layout, c);
+    if (layout->clients == NULL)
+    {
+        g_hash_table_remove (c->screen_info->tile_layouts,
+                             TILE_LAYOUT_KEY (layout->workspace, layout->monitor));
+        return NULL;
+    }
+
+    return layout;
+}
+
+void
+tilingInit (ScreenInfo *screen_info)
+{
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering tilingInit");
+
+    screen_info->tile_layouts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                       NULL, tilingFreeLayout);
+}
+
+void
+tilingClose (ScreenInfo *screen_info)
+{
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering tilingClose");
+
+    if (screen_info->tile_layouts)
+    {
+        /* Windows are about to be unframed, no need to retile them one by one */
+        g_hash_table_destroy (screen_info->tile_layouts);
+        screen_info->tile_layouts = NULL;
+    }
+    tilingInvalidateZones (screen_info);
+}
+
+/*
+   Push the geometry of the tiles that changed, plus "force" if given,
+   as one transaction
+ */
+static void
+tilingConfigureLayout (TileLayout *layout, Client *force)
+{
+    GdkRectangle *rect;
+    XWindowChanges wc;
+    GList *list;
+    Client *c;
+
+    clientConfigureBegin (layout->screen_info);
+    for (list = layout->clients; list; list = g_list_next (list))
+    {
+        c = (Client *) list->data;
+        if (!tilingIsShown (c) || FLAG_TEST (c->flags, CLIENT_FLAG_FULLSCREEN | CLIENT_FLAG_MAXIMIZED))
+        {
+            continue;
+        }
+
+        rect = &c->tile_node->area;
+        wc.x = rect->x + frameLeft (c);
+        wc.y = rect->y + frameTop (c);
+        wc.width = rect->width - frameLeft (c) - frameRight (c);
+        wc.height = rect->height - frameTop (c) - frameBottom (c);
+        if ((c != force) && (wc.x == c->x) && (wc.y == c->y)
+            && (wc.width == c->width) && (wc.height == c->height))
+        {
+            continue;
+        }
+        if (c == force)
+        {
+            /* The window being resized ignores CWX/CWY, see clientConfigure () */
+            c->x = wc.x;
+            c->y = wc.y;
+        }
+        clientConfigure (c, &wc, CWX | CWY | CWWidth | CWHeight, NO_CFG_FLAG);
+    }
+    clientConfigureEnd (layout->screen_info);
+}
+
+static void
+tilingNodeSyncRatio (TileNode *node)
+{
+    GdkRectangle *first, *second;
+
+    if (node->c)
+    {
+        return;
+    }
+    tilingNodeSyncRatio (node->child[0]);
+    tilingNodeSyncRatio (node->child[1]);
+
+    first = &node->child[0]->area;
+    second = &node->child[1]->area;
+    if (!tilingNodeIsShown (node->child[0]) || !tilingNodeIsShown (node->child[1]))
+    {
+        node->area = (tilingNodeIsShown (node->child[0]) ? *first : *second);
+        return;
+    }
+    gdk_rectangle_union (first, second, &node->area);
+    if ((node->vertical) && (node->area.height > 0))
+    {
+        node->ratio = (gdouble) first->height / node->area.height;
+    }
+    else if (!(node->vertical) && (node->area.width > 0))
+    {
+        node->ratio = (gdouble) first->width / node->area.width;
+    }
+}
+
+/* Update the layout parameters so that the next relayout keeps the tiles size */
+static void
+tilingSyncRatio (TileLayout *layout)
+{
+    GdkRectangle area;
+    GdkRectangle *rect;
+    GList *list;
+    Client *c;
+    gint i, count;
+
+    if (layout->type == TILE_LAYOUT_BSP)
+    {
+        if (layout->root)
+        {
+            tilingNodeSyncRatio (layout->root);
+        }
+        return;
+    }
+
+    area = tilingGetZones (layout->screen_info, layout->monitor)->zone[TILE_ZONE_MAXIMIZE];
+    for (list = layout->columns[TILE_COLUMN_MASTER]; list; list = g_list_next (list))
+    {
+        c = (Client *) list->data;
+        if (tilingIsShown (c) && (area.width > 0))
+        {
+            rect = &c->tile_node->area;
+            layout->master_ratio = CLAMP ((gdouble) (rect->x + rect->width - area.x) / area.width, 0.1, 0.9);
+            break;
+        }
+    }
+
+    /* Row heights become weights averaging 1.0, so that newcomers get a fair share */
+    if (area.height <= 0)
+    {
+        return;
+    }
+    for (i = 0; i < TILE_COLUMN_COUNT; i++)
+    {
+        count = 0;
+        for (list = layout->columns[i]; list; list = g_list_next (list))
+        {
+            if (tilingIsShown ((Client *) list->data))
+            {
+                count++;
+            }
+        }
+        for (list = layout->columns[i]; list; list = g_list_next (list))
+        {
+            c = (Client *) list->data;
+            if (tilingIsShown (c))
+            {
+                rect = &c->tile_node->area;
+                c->tile_node->weight = MAX ((gdouble) rect->height * count / area.height, 0.1);
+            }
+        }
+    }
+}
+
+void
+tilingApply (TileLayout *layout)
+{
+    GdkRectangle area;
+
+    g_return_if_fail (layout != NULL);
+    TRACE ("entering tilingApply");
+
+    /* First compute every geometry of the layout... */
+    area = tilingGetZones (layout->screen_info, layout->monitor)->zone[TILE_ZONE_MAXIMIZE];
+    if (layout->type == TILE_LAYOUT_BSP)
+    {
+        if (layout->root)
+        {
+            tilingNodeLayout (layout->root, &area);
+        }
+    }
+    else
+    {
+        tilingMasterLayout (layout, &area);
+    }
+    tilingBuildEdges (layout);
+
+    /* ...then push only the ones that actually changed */
+    tilingConfigureLayout (layout, NULL);
+}
+
+void
+tilingResizeClient (Client *c)
+{
+    ScreenInfo *screen_info;
+    TileLayout *layout;
+    TileEdge *edge;
+    GdkRectangle *area;
+    gint fx, fy, fw, fh;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingResizeClient");
+
+    layout = c->tile_layout;
+    if ((layout == NULL) || FLAG_TEST (c->flags, CLIENT_FLAG_MAXIMIZED))
+    {
+        return;
+    }
+
+    screen_info = c->screen_info;
+    area = &c->tile_node->area;
+    fx = frameX (c);
+    fy = frameY (c);
+    fw = frameWidth (c);
+    fh = frameHeight (c);
+
+    /* Drag along the edges shared with the neighbours for every side moved */
+    if (fx != area->x)
+    {
+        edge = tilingFindEdge (layout, c, TRUE, TRUE);
+        if (edge)
+        {
+            tilingMoveEdge (edge, fx);
+        }
+        else
+        {
+            area->width += area->x - fx;
+            area->x = fx;
+        }
+    }
+    if (fx + fw != area->x + area->width)
+    {
+        edge = tilingFindEdge (layout, c, TRUE, FALSE);
+        if (edge)
+        {
+            tilingMoveEdge (edge, fx + fw);
+        }
+        else
+        {
+            area->width = fx + fw - area->x;
+        }
+    }
+    if (!FLAG_TEST (c->flags, CLIENT_FLAG_SHADED))
+    {
+        if (fy != area->y)
+        {
+            edge = tilingFindEdge (layout, c, FALSE, TRUE);
+            if (edge)
+            {
+                tilingMoveEdge (edge, fy);
+            }
+            else
+            {
+                area->height += area->y - fy;
+                area->y = fy;
+            }
+        }
+        if (fy + fh != area->y + area->height)
+        {
+            edge = tilingFindEdge (layout, c, FALSE, FALSE);
+            if (edge)
+            {
+                tilingMoveEdge (edge, fy + fh);
+            }
+            else
+            {
+                area->height = fy + fh - area->y;
+            }
+        }
+    }
+
+    /* One batch per motion, but not faster than the clients can redraw */
+    if (screen_info->configure_pending > 0)
+    {
+        TRACE ("still waiting for clients to redraw, skipping");
+        return;
+    }
+    tilingConfigureLayout (layout, c);
+}
+
+void
+tilingResizeDone (Client *c)
+{
+    TileLayout *layout;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingResizeDone");
+
+    layout = c->tile_layout;
+    if (layout == NULL)
+    {
+        return;
+    }
+
+    /* Frames skipped while waiting for the clients are flushed here */
+    tilingConfigureLayout (layout, c);
+    tilingSyncRatio (layout);
+}
+
+void
+tilingManageClient (Client *c)
+{
+    ScreenInfo *screen_info;
+    TileLayout *layout;
+    gint cx, cy;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingManageClient");
+
+    screen_info = c->screen_info;
+    if ((screen_info->params->tile_layout == TILE_LAYOUT_NONE) || (c->tile_layout)
+        || !tilingIsTileable (c) || FLAG_TEST (c->flags, CLIENT_FLAG_MAXIMIZED))
+    {
+        return;
+    }
+
+    cx = frameX (c) + frameWidth (c) / 2;
+    cy = frameY (c) + frameHeight (c) / 2;
+    layout = tilingLookupLayout (screen_info, c->win_workspace,
+                                 myScreenFindMonitorIndexAtPoint (screen_info, cx, cy), TRUE);
+    tilingInsert (layout, c, cx, cy, TILE_NO_SIDE);
+    tilingApply (layout);
+}
+
+void
+tilingUnmanageClient (Client *c)
+{
+    TileLayout *layout;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingUnmanageClient");
+
+    layout = tilingDetach (c);
+    if (layout)
+    {
+        tilingApply (layout);
+    }
+}
+
+void
+tilingRefreshClient (Client *c)
+{
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingRefreshClient");
+
+    if (c->tile_layout)
+    {
+        tilingApply (c->tile_layout);
+    }
+}
+
+void
+tilingUpdateWorkspace (Client *c, guint ws)
+{
+    TileLayout *layout;
+    gint monitor;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingUpdateWorkspace");
+
+    if ((c->tile_layout == NULL) || (c->tile_layout->workspace == ws))
+    {
+        return;
+    }
+
+    clientConfigureBegin (c->screen_info);
+    monitor = c->tile_layout->monitor;
+    layout = tilingDetach (c);
+    if (layout)
+    {
+        tilingApply (layout);
+    }
+
+    layout = tilingLookupLayout (c->screen_info, ws, monitor, TRUE);
+    tilingInsert (layout, c, 0, 0, TILE_NO_SIDE);
+    tilingApply (layout);
+    clientConfigureEnd (c->screen_info);
+}
+
+gint
+tilingGetZone (ScreenInfo *screen_info, gint x, gint y)
+{
+    TileZones *zones;
+    GdkRectangle *rect;
+    gboolean left, right, top, bottom;
+
+    g_return_val_if_fail (screen_info != NULL, TILE_NO_ZONE);
+
+    /* The outermost pixels of the screen are left to the workspace wrapping */
+    if ((x <= 0) || (y <= 0) || (x >= screen_info->width - 1) || (y >= screen_info->height - 1))
+    {
+        return TILE_NO_ZONE;
+    }
+
+    /*
+     * Every monitor has its own hot edges, including the ones it shares
+     * with its neighbours. Both the monitor and its zones are cached.
+     */
+    zones = tilingGetZones (screen_info, myScreenFindMonitorIndexAtPoint (screen_info, x, y));
+    rect = &zones->monitor;
+    if ((x < rect->x) || (x >= rect->x + rect->width)
+        || (y < rect->y) || (y >= rect->y + rect->height))
+    {
+        /* Dead space between monitors of different sizes */
+        return TILE_NO_ZONE;
+    }
+
+    left = (x < rect->x + TILE_EDGE_BAND);
+    right = (x >= rect->x + rect->width - TILE_EDGE_BAND);
+    top = (y < rect->y + TILE_EDGE_BAND);
+    bottom = (y >= rect->y + rect->height - TILE_EDGE_BAND);
+
+    if (left)
+    {
+        return (top ? TILE_ZONE_TOP_LEFT : (bottom ? TILE_ZONE_BOTTOM_LEFT : TILE_ZONE_LEFT));
+    }
+    if (right)
+    {
+        return (top ? TILE_ZONE_TOP_RIGHT : (bottom ? TILE_ZONE_BOTTOM_RIGHT : TILE_ZONE_RIGHT));
+    }
+    if (top)
+    {
+        return TILE_ZONE_MAXIMIZE;
+    }
+    if (bottom)
+    {
+        return TILE_ZONE_THIRD_LEFT + (x - rect->x) * 3 / rect->width;
+    }
+
+    return TILE_NO_ZONE;
+}
+
+gboolean
+tilingGetZoneArea (ScreenInfo *screen_info, gint x, gint y, gint zone, GdkRectangle *rect)
+{
+    g_return_val_if_fail (screen_info != NULL, FALSE);
+    g_return_val_if_fail (rect != NULL, FALSE);
+
+    if ((zone < 0) || (zone >= TILE_ZONE_COUNT))
+    {
+        return FALSE;
+    }
+    *rect = tilingGetZones (screen_info, myScreenFindMonitorIndexAtPoint (screen_info, x, y))->zone[zone];
+
+    return TRUE;
+}
+
+void
+tilingSnapClient (Client *c, gint x, gint y, gint zone)
+{
+    ScreenInfo *screen_info;
+    GdkRectangle *rect;
+    XWindowChanges wc;
+
+    g_return_if_fail (c != NULL);
+    g_return_if_fail (zone >= 0 && zone < TILE_ZONE_COUNT);
+    TRACE ("entering tilingSnapClient");
+
+    if (zone == TILE_ZONE_LEFT)
+    {
+        tilingDropClient (c, x, y, SIDE_LEFT);
+        return;
+    }
+    if (zone == TILE_ZONE_RIGHT)
+    {
+        tilingDropClient (c, x, y, SIDE_RIGHT);
+        return;
+    }
+
+    /* Other zones are not part of any layout */
+    tilingUnmanageClient (c);
+    if (zone == TILE_ZONE_MAXIMIZE)
+    {
+        if (!FLAG_TEST (c->flags, CLIENT_FLAG_MAXIMIZED))
+        {
+            clientToggleMaximized (c, WIN_STATE_MAXIMIZED, TRUE);
+        }
+        return;
+    }
+    if (!tilingIsTileable (c))
+    {
+        return;
+    }
+    if (FLAG_TEST (c->flags, CLIENT_FLAG_MAXIMIZED))
+    {
+        clientRemoveMaximizeFlag (c);
+    }
+
+    screen_info = c->screen_info;
+    rect = &tilingGetZones (screen_info, myScreenFindMonitorIndexAtPoint (screen_info, x, y))->zone[zone];
+    wc.x = rect->x + frameLeft (c);
+    wc.y = rect->y + frameTop (c);
+    wc.width = rect->width - frameLeft (c) - frameRight (c);
+    wc.height = rect->height - frameTop (c) - frameBottom (c);
+    if ((wc.x != c->x) || (wc.y != c->y) || (wc.width != c->width) || (wc.height != c->height))
+    {
+        clientConfigure (c, &wc, CWX | CWY | CWWidth | CWHeight, NO_CFG_FLAG);
+    }
+}
+
+void
+tilingDropClient (Client *c, gint x, gint y, gint side)
+{
+    ScreenInfo *screen_info;
+    TileLayout *previous;
+    TileLayout *layout;
+
+    g_return_if_fail (c != NULL);
+    TRACE ("entering tilingDropClient");
+
+    if (!tilingIsTileable (c))
+    {
+        return;
+    }
+
+    screen_info = c->screen_info;
+    previous = tilingDetach (c);
+    if (FLAG_TEST (c->flags, CLIENT_FLAG_MAXIMIZED))
+    {
+        clientRemoveMaximizeFlag (c);
+    }
+
+    layout = tilingLookupLayout (screen_info, c->win_workspace,
+                                 myScreenFindMonitorIndexAtPoint (screen_info, x, y), TRUE);
+    clientConfigureBegin (screen_info);
+    if ((previous) && (previous != layout))
+    {
+        tilingApply (previous);
+    }
+    tilingInsert (layout, c, x, y, side);
+    tilingApply (layout);
+    clientConfigureEnd (screen_info);
+}
+
+void
+tilingSetLayoutType (ScreenInfo *screen_info, gint type)
+{
+    GList *layouts, *clients;
+    GList *list, *list2;
+    TileLayout *layout;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering tilingSetLayoutType");
+
+    if (type == TILE_LAYOUT_NONE)
+    {
+        type = TILE_LAYOUT_MASTER;
+    }
+
+    clientConfigureBegin (screen_info);
+    layouts = g_hash_table_get_values (screen_info->tile_layouts);
+    for (list = layouts; list; list = g_list_next (list))
+    {
+        layout = (TileLayout *) list->data;
+        if (layout->type != type)
+        {
+            /* Rebuild the layout from scratch, keeping the tiling order */
+            clients = g_list_copy (layout->clients);
+            for (list2 = clients; list2; list2 = g_list_next (list2))
+            {
+                tilingRemove (layout, (Client *) list2->data);
+            }
+            layout->type = type;
+            for (list2 = clients; list2; list2 = g_list_next (list2))
+            {
+                tilingInsert (layout, (Client *) list2->data, 0, 0, TILE_NO_SIDE);
+            }
+            g_list_free (clients);
+        }
+        tilingApply (layout);
+    }
+    g_list_free (layouts);
+    clientConfigureEnd (screen_info);
+}
+
+void
+tilingScreenResize (ScreenInfo *screen_info)
+{
+    GList *layouts, *orphans;
+    GList *list;
+    TileLayout *layout;
+    Client *c;
+    gint num_monitors;
+
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering tilingScreenResize");
+
+    tilingInvalidateZones (screen_info);
+    num_monitors = myScreenGetNumMonitors (screen_info);
+
+    /* Move the windows from monitors that went away to the last one left */
+    orphans = NULL;
+    layouts = g_hash_table_get_values (screen_info->tile_layouts);
+    for (list = layouts; list; list = g_list_next (list))
+    {
+        layout = (TileLayout *) list->data;
+        if (layout->monitor >= num_monitors)
+        {
+            orphans = g_list_concat (orphans, g_list_copy (layout->clients));
+        }
+    }
+    g_list_free (layouts);
+
+    for (list = orphans; list; list = g_list_next (list))
+    {
+        c = (Client *) list->data;
+        tilingDetach (c);
+        layout = tilingLookupLayout (screen_info, c->win_workspace, num_monitors - 1, TRUE);
+        tilingInsert (layout, c, 0, 0, TILE_NO_SIDE);
+    }
+    g_list_free (orphans);
+
+    clientConfigureBegin (screen_info);
+    layouts = g_hash_table_get_values (screen_info->tile_layouts);
+    for (list = layouts; list; list = g_list_next (list))
+    {
+        tilingApply ((TileLayout *) list->data);
+    }
+    g_list_free (layouts);
+    clientConfigureEnd (screen_info);
+}
+
+void
+tilingInvalidateZones (ScreenInfo *screen_info)
+{
+    g_return_if_fail (screen_info != NULL);
+    TRACE ("entering tilingInvalidateZones");
+
+    if (screen_info->tile_zones)
+    {
+        g_array_free (screen_info->tile_zones, TRUE);
+        screen_info->tile_zones = NULL;
+    }
+}
@@ -0,0 +1,172 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2011 Olivier Fourdan
+
+ */
+
+#ifndef INC_TILING_H
+#define INC_TILING_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+#include <gdk/gdk.h>
+
+#include "screen.h"
+#include "client.h"
+
+#ifndef TILE_DEFAULT_RATIO
+#define TILE_DEFAULT_RATIO              0.5
+#endif
+
+#ifndef TILE_EDGE_BAND
+#define TILE_EDGE_BAND                  50
+#endif
+
+#ifndef TILE_MIN_SIZE
+#define TILE_MIN_SIZE                   50
+#endif
+
+#define TILE_NO_SIDE                    -1
+#define TILE_NO_ZONE                    -1
+
+enum
+{
+    TILE_LAYOUT_NONE = 0,
+    TILE_LAYOUT_MASTER,
+    TILE_LAYOUT_BSP
+};
+
+enum
+{
+    TILE_COLUMN_MASTER = 0,
+    TILE_COLUMN_STACK,
+    TILE_COLUMN_COUNT
+};
+
+enum
+{
+    TILE_ZONE_LEFT = 0,
+    TILE_ZONE_RIGHT,
+    TILE_ZONE_TOP_LEFT,
+    TILE_ZONE_TOP_RIGHT,
+    TILE_ZONE_BOTTOM_LEFT,
+    TILE_ZONE_BOTTOM_RIGHT,
+    TILE_ZONE_THIRD_LEFT,
+    TILE_ZONE_THIRD_CENTER,
+    TILE_ZONE_THIRD_RIGHT,
+    TILE_ZONE_MAXIMIZE,
+    TILE_ZONE_COUNT
+};
+
+/*
+ * Snap zones of a monitor, computed once from the monitor geometry
+ * and the struts, and kept until either of them changes.
+ */
+struct _TileZones
+{
+    GdkRectangle monitor;
+    GdkRectangle zone[TILE_ZONE_COUNT];
+};
+
+/*
+ * A node of the BSP tree. Leaves hold a client, inner nodes split
+ * their area between child[0] (left or top) and child[1] (right or
+ * bottom) according to ratio. In master/stack layouts, weight is the
+ * share of its column a client gets, relative to the others.
+ */
+struct _TileNode
+{
+    TileNode *parent;
+    TileNode *child[2];
+    Client *c;
+    gboolean vertical;
+    gdouble ratio;
+    gdouble weight;
+    GdkRectangle area;
+};
+
+/*
+ * An edge shared by adjacent tiles. "before" lists the clients having
+ * their right (or bottom) side on it, "after" the ones having their
+ * left (or top) side on it; moving the edge resizes all of them.
+ */
+struct _TileEdge
+{
+    gboolean vertical;
+    gint pos;
+    gint start;
+    gint end;
+    GList *before;
+    GList *after;
+};
+
+/*
+ * One layout per workspace and per (logical) monitor. Master/stack
+ * layouts keep their clients in two columns, BSP layouts in a tree.
+ * "clients" always lists every client of the layout, in tiling order.
+ */
+struct _TileLayout
+{
+    ScreenInfo *screen_info;
+    guint workspace;
+    gint monitor;
+    gint type;
+    GList *clients;
+    GList *columns[TILE_COLUMN_COUNT];
+    TileNode *root;
+    GList *edges;
+    gdouble master_ratio;
+};
+
+gboolean                 tilingIsTileable                       (Client *);
+void                     tilingInit                             (ScreenInfo *);
+void                     tilingClose                            (ScreenInfo *);
+void                     tilingManageClient                     (Client *);
+void                     tilingUnmanageClient                   (Client *);
+void                     tilingRefreshClient                    (Client *);
+void                     tilingUpdateWorkspace                  (Client *,
+                                                                 guint);
+gint                     tilingGetZone                          (ScreenInfo *,
+                                                                 gint,
+                                                                 gint);
+gboolean                 tilingGetZoneArea                      (ScreenInfo *,
+                                                                 gint,
+                                                                 gint,
+                                                                 gint,
+                                                                 GdkRectangle *);
+void                     tilingSnapClient                       (Client *,
+                                                                 gint,
+                                                                 gint,
+                                                                 gint);
+void                     tilingDropClient                       (Client *,
+                                                                 gint,
+                                                                 gint,
+                                                                 gint);
+void                     tilingApply                            (TileLayout *);
+void                     tilingResizeClient                     (Client *);
+void                     tilingResizeDone                       (Client *);
+void                     tilingSetLayoutType                    (ScreenInfo *,
+                                                                 gint);
+void                     tilingScreenResize                     (ScreenInfo *);
+void                     tilingInvalidateZones                  (ScreenInfo *);
+
+#endif /* INC_TILING_H */
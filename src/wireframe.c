@@ -36,80 +36,101 @@
 
 #include "screen.h"
 #include "client.h"
+#include "compositor.h"
 #include "frame.h"
+#include "hints.h"
 #include "wireframe.h"
 
 #ifndef OUTLINE_WIDTH
 #define OUTLINE_WIDTH 5
 #endif
 
-void
-wireframeUpdate (Client *c, Window xwindow)
-{
-    ScreenInfo *screen_info;
+#ifndef PREVIEW_OPACITY
+#define PREVIEW_OPACITY 0x50000000
+#endif
 
-    g_return_if_fail (c != NULL);
-    g_return_if_fail (xwindow != None);
+static void
+wireframeDrawOutline (ScreenInfo *screen_info, Window xwindow,
+                      int x, int y, int width, int height, gboolean shaped)
+{
+    Display *dpy;
 
-    TRACE ("entering wireframeUpdate 0x%lx", xwindow);
-    screen_info = c->screen_info;
-    XUnmapWindow (clientGetXDisplay (c), xwindow);
-    XMoveResizeWindow (clientGetXDisplay (c), xwindow,
-                       frameX (c), frameY (c), frameWidth (c), frameHeight (c));
+    dpy = myScreenGetXDisplay (screen_info);
+    XUnmapWindow (dpy, xwindow);
+    XMoveResizeWindow (dpy, xwindow, x, y, width, height);
 
-    if ((frameWidth (c) > OUTLINE_WIDTH * 2) && (frameHeight (c) > OUTLINE_WIDTH * 2))
+    if ((width > OUTLINE_WIDTH * 2) && (height > OUTLINE_WIDTH * 2))
     {
-        XRectangle xrect;
-        Region inner_xregion;
-        Region outer_xregion;
-
-        inner_xregion = XCreateRegion ();
-        outer_xregion = XCreateRegion ();
-
-        xrect.x = 0;
-        xrect.y = 0;
-        xrect.width = frameWidth (c);
-        xrect.height = frameHeight (c);
-        XUnionRectWithRegion (&xrect, outer_xregion, outer_xregion);
-
-        xrect.x += OUTLINE_WIDTH;
-        xrect.y += OUTLINE_WIDTH;
-        xrect.width -= OUTLINE_WIDTH * 2;
-        xrect.height -= OUTLINE_WIDTH * 2;
-
-        XUnionRectWithRegion (&xrect, inner_xregion, inner_xregion);
-
-        XSubtractRegion (outer_xregion, inner_xregion, outer_xregion);
-
-        XShapeCombineRegion (clientGetXDisplay (c), xwindow, ShapeBounding,
-                             0, 0, outer_xregion, ShapeSet);
-
-        XDestroyRegion (outer_xregion);
-        XDestroyRegion (inner_xregion);
-        XMapWindow (clientGetXDisplay (c), xwindow);
-
-        XDrawRectangle (clientGetXDisplay (c), xwindow,
+        if (shaped)
+        {
+            XRectangle xrect;
+            Region inner_xregion;
+            Region outer_xregion;
+
+            inner_xregion = XCreateRegion ();
+            outer_xregion = XCreateRegion ();
+
+            xrect.x = 0;
+            xrect.y = 0;
+            xrect.width = width;
+            xrect.height = height;
+            XUnionRectWithRegion (&xrect, outer_xregion, outer_xregion);
+
+            xrect.x += OUTLINE_WIDTH;
+            xrect.y += OUTLINE_WIDTH;
+            xrect.width -= OUTLINE_WIDTH * 2;
+            xrect.height -= OUTLINE_WIDTH * 2;
+
+            XUnionRectWithRegion (&xrect, inner_xregion, inner_xregion);
+
+            XSubtractRegion (outer_xregion, inner_xregion, outer_xregion);
+
+            XShapeCombineRegion (dpy, xwindow, ShapeBounding,
+                                 0, 0, outer_xregion, ShapeSet);
+
+            XDestroyRegion (outer_xregion);
+            XDestroyRegion (inner_xregion);
+        }
+        else
+        {
+            XShapeCombineMask (dpy, xwindow,
+                               ShapeBounding, 0, 0, None, ShapeSet);
+        }
+        XMapWindow (dpy, xwindow);
+
+        XDrawRectangle (dpy, xwindow,
                         gdk_x11_gc_get_xgc (screen_info->white_gc),
-                        0, 0, frameWidth (c) - 1, frameHeight (c) - 1);
+                        0, 0, width - 1, height - 1);
 
-        XDrawRectangle (clientGetXDisplay (c), xwindow,
+        XDrawRectangle (dpy, xwindow,
                         gdk_x11_gc_get_xgc (screen_info->white_gc),
                         OUTLINE_WIDTH - 1, OUTLINE_WIDTH - 1,
-                        frameWidth (c) - 2 * (OUTLINE_WIDTH - 1) - 1,
-                        frameHeight (c)- 2 * (OUTLINE_WIDTH - 1) - 1);
+                        width - 2 * (OUTLINE_WIDTH - 1) - 1,
+                        height - 2 * (OUTLINE_WIDTH - 1) - 1);
     }
     else
     {
         /* Unset the shape */
-        XShapeCombineMask (clientGetXDisplay (c), xwindow,
+        XShapeCombineMask (dpy, xwindow,
                            ShapeBounding, 0, 0, None, ShapeSet);
-        XMapWindow (clientGetXDisplay (c), xwindow);
+        XMapWindow (dpy, xwindow);
 
-        XDrawRectangle (clientGetXDisplay (c), xwindow,
+        XDrawRectangle (dpy, xwindow,
                         gdk_x11_gc_get_xgc (screen_info->white_gc),
-                        0, 0, frameWidth (c) - 1, frameHeight (c) - 1);
+                        0, 0, width - 1, height - 1);
     }
-    XFlush (clientGetXDisplay (c));
+    XFlush (dpy);
+}
+
+void
+wireframeUpdate (Client *c, Window xwindow)
+{
+    g_return_if_fail (c != NULL);
+    g_return_if_fail (xwindow != None);
+
+    TRACE ("entering wireframeUpdate 0x%lx", xwindow);
+    wireframeDrawOutline (c->screen_info, xwindow,
+                          frameX (c), frameY (c), frameWidth (c), frameHeight (c), TRUE);
 }
 
 Window
@@ -149,3 +170,50 @@ wireframeDelete (ScreenInfo *screen_info, Window xwindow)
     XUnmapWindow (myScreenGetXDisplay (screen_info), xwindow);
     XDestroyWindow (myScreenGetXDisplay (screen_info), xwindow);
 }
+
+/*
+   The preview shows where a window is about to be snapped. When
+   compositing, the compositor paints it as a translucent area,
+   otherwise it is a plain outline like the wireframe above.
+ */
+Window
+wireframePreviewCreate (ScreenInfo *screen_info)
+{
+    DisplayInfo *display_info;
+    XSetWindowAttributes attrs;
+    Window xwindow;
+
+    g_return_val_if_fail (screen_info != NULL, None);
+
+    TRACE ("entering wireframePreviewCreate");
+
+    display_info = screen_info->display_info;
+    attrs.override_redirect = True;
+    attrs.background_pixel = BlackPixel (display_info->dpy, screen_info->screen);
+    xwindow = XCreateWindow (display_info->dpy, screen_info->xroot,
+                             0, 0, 1, 1,
+                             0, CopyFromParent, CopyFromParent,
+                             (Visual *) CopyFromParent,
+                             CWOverrideRedirect | CWBackPixel, &attrs);
+    setHint (display_info, xwindow, NET_WM_WINDOW_OPACITY, PREVIEW_OPACITY);
+
+    return (xwindow);
+}
+
+void
+wireframePreviewUpdate (ScreenInfo *screen_info, Window xwindow, GdkRectangle *rect)
+{
+    g_return_if_fail (screen_info != NULL);
+    g_return_if_fail (xwindow != None);
+
+    TRACE ("entering wireframePreviewUpdate 0x%lx", xwindow);
+
+    if (rect == NULL)
+    {
+        XUnmapWindow (myScreenGetXDisplay (screen_info), xwindow);
+        XFlush (myScreenGetXDisplay (screen_info));
+        return;
+    }
+    wireframeDrawOutline (screen_info, xwindow, rect->x, rect->y, rect->width, rect->height,
+                          !compositorIsUsable (screen_info->display_info));
+}
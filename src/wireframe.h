@@ -29,6 +29,7 @@
 #endif
 
 #include <X11/Xlib.h>
+#include <gdk/gdk.h>
 #include "screen.h"
 #include "client.h"
 
@@ -37,5 +38,9 @@ void                     wireframeUpdate                        (Client *c,
 Window                   wireframeCreate                        (Client *c);
 void                     wireframeDelete                        (ScreenInfo *,
                                                                  Window);
+Window                   wireframePreviewCreate                 (ScreenInfo *);
+void                     wireframePreviewUpdate                 (ScreenInfo *,
+                                                                 Window,
+                                                                 GdkRectangle *);
 
 #endif /* INC_WIREFRAME_H */
@@ -45,6 +45,7 @@
 #include "focus.h"
 #include "stacking.h"
 #include "hints.h"
+#include "tiling.h"
 
 static void
 workspaceGetPosition (ScreenInfo *screen_info, int n, int * row, int * col)
@@ -559,6 +560,9 @@ workspaceUpdateArea (ScreenInfo *screen_info)
         }
     }
 
+    /* Struts may have changed even if the margins did not */
+    tilingInvalidateZones (screen_info);
+
     if ((prev_top != screen_info->margins[STRUTS_TOP]) || (prev_left != screen_info->margins[STRUTS_LEFT])
         || (prev_right != screen_info->margins[STRUTS_RIGHT])
         || (prev_bottom != screen_info->margins[STRUTS_BOTTOM]))
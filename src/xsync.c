@@ -164,6 +164,7 @@ clientXSyncTimeout (gpointer data)
         clientXSyncClearTimeout (c);
         c->xsync_waiting = FALSE;
         c->xsync_enabled = FALSE;
+        clientConfigureAck (c);
 
         wc.x = c->x;
         wc.y = c->y;